@@ -2,23 +2,40 @@
 #define BFS_SOLVER_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "move.h"
+#include "move_table.h"
+#include "search_kernel.h"
+#include "move_automaton.h"
 
-typedef struct node
-{
-    uint64_t steps; // records steps better than the linkedlist
-    struct node* next;
-    uint32_t state; // current steps
-    int8_t steps_size; // how many steps
+#define BFS_BLOCK_SIZE 256 // how many frontier nodes are expanded at once by the batch kernels
+#define BFS_THREAD_NODES 4096 // the fewest frontier nodes worth one more thread
+#define BFS_MAX_DEPTH 64 // the longest path the BFS can print
+
+#define BFS_DEDUP_NONE 0 // every path is queued
+#define BFS_DEDUP_FIRST 1 // only the first path found to every state is queued
+#define BFS_DEDUP_ALL 2 // every state is queued once, with all the shortest paths to it
 
-} Node;
+#define BFS_NO_CONTEXT UINT32_MAX // the automaton state of the nodes of a search without automaton, not stored
 
-typedef struct queue
+typedef struct bfs_frontier
 {
-    int64_t size;
-    Node* head;
-    Node* last;
-} Queue;
+    uint32_t* states; // current states (dense indices when walking a transition table), freed once expanded
+    uint8_t* phases; // edge phases of the states, freed once expanded
+    uint32_t* parents; // the index of the parent of every node in the level before
+    uint8_t* moves; // the last move of every node
+    uint32_t* contexts; // the automaton state of every node, NULL without an automaton, freed once expanded
+    size_t size;
+    size_t capacity;
+} BfsFrontier;
+
+typedef struct bfs_parents
+{
+    uint32_t* first; // the paths into node i are first[i] ... first[i + 1] - 1
+    uint32_t* parents; // the index of the parent of every path in the previous level
+    uint8_t* serials; // the last move of every path
+    size_t size; // how many nodes
+} BfsParents;
 
 /**
  *                       Solves a cube using BFS algorithm.
@@ -27,6 +44,12 @@ typedef struct queue
  * the initial edge phase, the minimum depth, and the maximum depth, and solves a cube using BFS algorithm.
  * If the cube is solvable, print all solutions by using BFS algorithm.
  *
+ * The levels are searched one after the other, each stored as contiguous arrays: every level
+ * is split between the threads, which write the next level into buffers of their own, and
+ * a state already queued is skipped by looking it up in a lock-free bitmap of the ranked states.
+ * BFS_DEDUP_FIRST keeps the first path found to every state, BFS_DEDUP_ALL keeps every
+ * shortest path to it as a parent of one node, so all the optimal solutions are printed.
+ *
  * @param moves                 An array of moves to use for solving the cube.
  * @param moves_map             A 2D array of moves to use for solving the cube.
  * @param original_states       An array of original states to check against.
@@ -34,7 +57,15 @@ typedef struct queue
  * @param edges_phase_state     The initial edge phase of the cube.
  * @param min_depth             The minimum depth of the solution.
  * @param max_depth             The maximum depth of the solution.
+ * @param table                 The transition table to walk instead of the move functions, or NULL.
+ * @param simd                  Expands the frontier block by block with the batch move kernels (ignored with a table).
+ * @param kernel                The generated kernel of moves_map, or NULL (ignored with a table, simd or an automaton).
+ * @param automaton             The pruning automaton to step instead of moves_map, or NULL (ignored with dedup).
+ * @param threads               How many threads expand every level, 0 for one per CPU.
+ * @param dedup                 BFS_DEDUP_NONE, BFS_DEDUP_FIRST or BFS_DEDUP_ALL.
  */
 void cube_bfs_solver(const Move* moves, const Move* moves_map, const int* original_states,
-                     uint32_t state, uint8_t edges_phase_state, uint8_t min_depth, uint8_t max_depth);
+                     uint32_t state, uint8_t edges_phase_state, uint8_t min_depth, uint8_t max_depth,
+                     const MoveTable* table, bool simd, const SearchKernel* kernel, const MoveAutomaton* automaton,
+                     uint16_t threads, uint8_t dedup);
 #endif
\ No newline at end of file
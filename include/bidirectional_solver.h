@@ -0,0 +1,54 @@
+#ifndef BIDIRECTIONAL_SOLVER_H
+#define BIDIRECTIONAL_SOLVER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "utils.h"
+#include "move.h"
+
+#define BIDIRECTIONAL_MAX_DEPTH 24 // 12 moves of 5 bits per half path
+#define BIDIRECTIONAL_NONE 0xff // the first move of a backward path that is still empty
+
+typedef struct bidirectional_node
+{
+    uint64_t key; // the packed state and the edge flip, state << 1 | flip
+    uint64_t steps; // the serial of move i at bits 5 * i, in the order the moves are played
+    uint8_t move; // the last move of a forward path, the first move of a backward path
+} BidirectionalNode;
+
+typedef struct bidirectional_level
+{
+    BidirectionalNode* nodes;
+    size_t size;
+    size_t capacity;
+} BidirectionalLevel;
+
+/**
+ *                       Solves a cube by searching from both ends.
+ *
+ * This function expands every path from the cube (forward) and every path leading to an
+ * original state (backward, with the moves undone), level by level, and sorts every level
+ * by state. A solution of length d is a forward path of d - k moves and a backward path
+ * of k = min(goal_depth, d) moves that meet on the same cube. The joined paths are printed
+ * if moves_map allows the backward path after the forward one, and no shorter prefix of at
+ * least min_depth moves solves the cube, so the solutions are the same as the BFS and DFS
+ * ones.
+ *
+ * The backward paths do not depend on the cube, so with a goal cache file they are
+ * read from it, or expanded once and written to it for the next queries.
+ *
+ * @param moves_map             A 2D array of moves to use for solving the cube.
+ * @param original_states       An array of original states to check against.
+ * @param state                 The initial state of the cube.
+ * @param edges_phase_state     The initial edge phase of the cube.
+ * @param min_depth             The minimum depth of the solution.
+ * @param max_depth             The maximum depth of the solution, at most BIDIRECTIONAL_MAX_DEPTH.
+ * @param goal_depth            The longest backward paths, at most BIDIRECTIONAL_MAX_DEPTH / 2.
+ * @param goal_cache            The path of the goal cache file, or NULL.
+ */
+void cube_bidirectional_solver(const Move* moves_map, const int* original_states,
+                               uint32_t state, uint8_t edges_phase_state, uint8_t min_depth, uint8_t max_depth,
+                               uint8_t goal_depth, const char* goal_cache);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef CUBE_ALGEBRA_H
+#define CUBE_ALGEBRA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ *                       Composes two packed states as permutations.
+ *
+ * A packed state maps every position to the piece on it. The result maps position i to
+ * a[b[i]], corners and edges apart. If either state ignores the edges (all set to zero),
+ * so does the result.
+ *
+ * @param a                     The permutation applied second.
+ * @param b                     The permutation applied first.
+ *
+ * @return                      The packed state of a after b.
+ */
+uint32_t cube_compose(uint32_t a, uint32_t b);
+
+/**
+ *                       Inverts a packed state as a permutation.
+ *
+ * @param state                 The packed state, every corner and edge must be present once.
+ *
+ * @return                      The packed state mapping every piece back to its position.
+ */
+uint32_t cube_inverse(uint32_t state);
+
+/**
+ *                       Builds the state of a start cube relative to a target cube.
+ *
+ * The relative state is inverse(target) after start. A sequence of moves takes start to
+ * target (in any whole cube orientation) exactly when it solves the relative state, so the
+ * solvers can aim at the original states for any target.
+ *
+ * @param start                 The packed state to start from.
+ * @param target                The packed state to reach.
+ *
+ * @return                      The relative packed state.
+ */
+uint32_t cube_relative(uint32_t start, uint32_t target);
+
+/**
+ *                       Builds the edge phase of a relative state.
+ *
+ * The quarter turns of the middle layer change the edge flip of any state the same way,
+ * so the relative state flips its edges when exactly one of start and target does.
+ *
+ * @param start                 The packed state to start from, every edge must be present.
+ * @param start_phase           The edge phase of start, as built by edges_phase_convert.
+ * @param target                The packed state to reach, every edge must be present.
+ * @param target_phase          The edge phase of target, as built by edges_phase_convert.
+ *
+ * @return                      The edge phase (following the Blue color) of cube_relative(start, target).
+ */
+uint8_t cube_relative_phase(uint32_t start, uint8_t start_phase, uint32_t target, uint8_t target_phase);
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef CUBE_RANK_H
+#define CUBE_RANK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CUBE_CORNERS_SIZE 40320 // 8! corner permutations
+#define CUBE_EDGES_SIZE 24 // 4! edge permutations
+#define CUBE_STATES_SIZE 967680 // packed states, corners * edges
+#define CUBE_PHASE_STATES_SIZE 1935360 // packed states * 2 edge flips
+
+/**
+ *                       Checks if a packed state is a legal cube.
+ *
+ * A legal packed state holds every corner exactly once, and either every edge exactly
+ * once or all edges set to zero (edges ignored).
+ *
+ * @param state                 The packed state to check.
+ *
+ * @return                      True if the state can be ranked, false otherwise.
+ */
+bool cube_state_valid(uint32_t state);
+
+/**
+ *                       Ranks the corner permutation of a packed state.
+ *
+ * @param state                 The packed state.
+ *
+ * @return                      The Lehmer code of the corners, in [0, CUBE_CORNERS_SIZE).
+ */
+uint32_t corners_rank(uint32_t state);
+
+/**
+ *                       Builds the packed state of a corner rank, edges are set to zero.
+ *
+ * @param index                 The Lehmer code of the corners, in [0, CUBE_CORNERS_SIZE).
+ *
+ * @return                      The packed state with all edges set to zero.
+ */
+uint32_t corners_unrank(uint32_t index);
+
+/**
+ *                       Ranks the edge permutation of a packed state.
+ *
+ * @param state                 The packed state.
+ *
+ * @return                      The Lehmer code of the edges, in [0, CUBE_EDGES_SIZE).
+ */
+uint32_t edges_rank(uint32_t state);
+
+/**
+ *                       Builds the edge bits of an edge rank.
+ *
+ * @param index                 The Lehmer code of the edges, in [0, CUBE_EDGES_SIZE).
+ *
+ * @return                      The lowest 8 bits of a packed state.
+ */
+uint32_t edges_unrank(uint32_t index);
+
+/**
+ *                       Extracts the edge flip of an edge phase.
+ *
+ * Every packed state can be reached with exactly 2 edge phases. The flip tells them apart,
+ * it does not depend on which color (Blue, Orange, Green or Red) the phase follows.
+ *
+ * @param state                 The packed state.
+ * @param phase                 The edge phase, as built by edges_phase_convert.
+ *
+ * @return                      The edge flip, 0 or 1 (0 for the original states).
+ */
+uint8_t edges_flip(uint32_t state, uint8_t phase);
+
+/**
+ *                       Builds the edge phase of a packed state and an edge flip.
+ *
+ * @param state                 The packed state.
+ * @param flip                  The edge flip, 0 or 1.
+ *
+ * @return                      The edge phase following the Blue color.
+ */
+uint8_t edges_phase(uint32_t state, uint8_t flip);
+
+/**
+ *                       Ranks a packed state, ignoring the edge phase.
+ *
+ * @param state                 The packed state, every edge must be present.
+ *
+ * @return                      The rank, in [0, CUBE_STATES_SIZE).
+ */
+uint32_t cube_state_rank(uint32_t state);
+
+/**
+ *                       Builds the packed state of a rank from cube_state_rank.
+ *
+ * @param index                 The rank, in [0, CUBE_STATES_SIZE).
+ *
+ * @return                      The packed state.
+ */
+uint32_t cube_state_unrank(uint32_t index);
+
+/**
+ *                       Ranks a packed state together with its edge phase.
+ *
+ * @param state                 The packed state, every edge must be present.
+ * @param phase                 The edge phase, as built by edges_phase_convert.
+ *
+ * @return                      The rank, in [0, CUBE_PHASE_STATES_SIZE).
+ */
+uint32_t cube_rank(uint32_t state, uint8_t phase);
+
+/**
+ *                       Builds the packed state and the edge phase of a rank from cube_rank.
+ *
+ * @param index                 The rank, in [0, CUBE_PHASE_STATES_SIZE).
+ * @param state                 Where to store the packed state.
+ * @param phase                 Where to store the edge phase (following the Blue color).
+ */
+void cube_unrank(uint32_t index, uint32_t* state, uint8_t* phase);
+
+#endif
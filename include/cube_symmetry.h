@@ -0,0 +1,91 @@
+#ifndef CUBE_SYMMETRY_H
+#define CUBE_SYMMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "move.h"
+
+#define CUBE_SYMMETRIES 16 // 8 whole cube rotations keeping the 223 shape, and their mirrors
+#define CUBE_SYMMETRY_IDENTITY 0
+
+typedef struct cube_symmetry
+{
+    bool mirror; // true if the symmetry reverses the orientation of the cube
+    uint8_t corners[8]; // corners[i]: the position that corner position i is sent to
+    uint8_t edges[4]; // edges[i]: the position that edge position i is sent to
+    uint8_t facelets[8]; // facelets[i]: the facelet that edge phase facelet i is sent to
+    uint8_t moves[19]; // moves[serial]: the move that does the same on a conjugated cube
+    uint8_t inverse; // the symmetry that undoes this one
+} CubeSymmetry;
+
+// CUBE_SYMMETRY[i], built by cube_symmetry_init, the identity comes first
+extern CubeSymmetry CUBE_SYMMETRY[CUBE_SYMMETRIES];
+
+// CUBE_SYMMETRY_PRODUCT[a][b]: the symmetry conjugating by b, then by a
+extern uint8_t CUBE_SYMMETRY_PRODUCT[CUBE_SYMMETRIES][CUBE_SYMMETRIES];
+
+/**
+ *                       Builds the symmetries of the 223 cube.
+ *
+ * The 16 symmetries are generated by a quarter turn of the whole cube around the U - D
+ * axis, a half turn around the horizontal axis through the front-left and back-right
+ * edges, and the mirror swapping the left and right faces. For every symmetry, the move
+ * of every serial is mapped to the move doing the same on the conjugated cube. Calling
+ * it again does nothing.
+ */
+void cube_symmetry_init();
+
+/**
+ *                       Conjugates a packed state by a symmetry.
+ *
+ * The cube is turned (or mirrored) by the symmetry, then its pieces are renamed after
+ * their new positions. Solved cubes stay solved, and applying a move to a state then
+ * conjugating is the same as conjugating then applying CUBE_SYMMETRY[symmetry].moves of
+ * that move. States with all edges set to zero (edges ignored) keep them at zero.
+ *
+ * @param state                 The packed state.
+ * @param symmetry              The symmetry, in [0, CUBE_SYMMETRIES).
+ *
+ * @return                      The conjugated packed state.
+ */
+uint32_t cube_conjugate(uint32_t state, uint8_t symmetry);
+
+/**
+ *                       Conjugates an edge phase by a symmetry.
+ *
+ * @param state                 The packed state the phase belongs to, every edge must be present.
+ * @param phase                 The edge phase, as built by edges_phase_convert.
+ * @param symmetry              The symmetry, in [0, CUBE_SYMMETRIES).
+ *
+ * @return                      The edge phase (following the Blue color) of the conjugated state.
+ */
+uint8_t cube_conjugate_phase(uint32_t state, uint8_t phase, uint8_t symmetry);
+
+/**
+ *                       Picks the representative of the symmetry class of a packed state.
+ *
+ * The representative is the smallest of the 16 conjugates of the state, so every state
+ * of a class gets the same one and tables can be keyed on it.
+ *
+ * @param state                 The packed state.
+ * @param symmetry              Where to store the symmetry conjugating state into the
+ *                               representative, or NULL.
+ *
+ * @return                      The representative packed state.
+ */
+uint32_t cube_canonical(uint32_t state, uint8_t* symmetry);
+
+/**
+ *                       Maps a sequence of moves back through a symmetry.
+ *
+ * If the moves solve the conjugate of a state by symmetry, the mapped moves solve the
+ * state itself.
+ *
+ * @param serials               The serials of the moves, replaced by the mapped serials.
+ * @param size                  How many moves.
+ * @param symmetry              The symmetry the moves were found for.
+ */
+void cube_symmetry_map_moves(uint8_t* serials, uint8_t size, uint8_t symmetry);
+
+#endif
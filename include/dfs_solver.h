@@ -2,10 +2,73 @@
 #define DFS_SOLVER_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
 
-#include "API.h"
 #include "utils.h"
 #include "move.h"
+#include "move_table.h"
+#include "macro_table.h"
+#include "move_automaton.h"
+#include "search_kernel.h"
+
+#define DFS_SPLIT_DEPTH 3 // paths shorter than this are split into tasks, longer ones are searched by one thread
+#define DFS_BUFFER_SIZE 65536 // how many bytes of solutions a thread keeps before printing them
+#define DFS_MAX_DEPTH 64 // the longest path a search can hold
+
+typedef struct dfs_solutions
+{
+    uint32_t count; // how many solutions are found
+    bool buffered; // false prints every solution at once, true keeps them in text
+    char* text; // the solutions not printed yet, one line each
+    size_t size; // how many bytes of text are used
+    pthread_mutex_t* print_lock; // taken while a buffer is printed, NULL if not buffered
+} DfsSolutions;
+
+typedef struct dfs_prune
+{
+    // true skips the packed state reached by last_move, which has moves_left moves before max_depth
+    bool (*cut)(void* data, uint32_t state, uint8_t phase, uint8_t last_move, uint8_t moves_left);
+    void* data; // given to cut
+} DfsPrune;
+
+/**
+ *                       A helper function to perform DFS algorithm.
+ *
+ * This function searches every path that starts with the given moves, without recursion
+ * and without allocating: the moves, the states and the edge phases of the current path
+ * are kept per depth in DfsStack, together with a cursor into the moves_map row of the
+ * last move of every depth.
+ *
+ * If the state after a path is an original state (and the path is at least min_depth long),
+ * the function checks if the edge phase is solved and if so, reports the path. The path is
+ * never extended past an original state or past max_depth.
+ *
+ * With a generated kernel, the path is searched by the kernel instead, which hard-wires
+ * the moves_map rows and inlines the moves, in the same order.
+ *
+ * With a prune hook, a move is not played if the hook cuts the cube after it, given the
+ * moves left before max_depth. IDA* cuts the cubes whose lower bound does not fit.
+ *
+ * @param state                 The state of the cube after the first moves.
+ * @param edges_phase_state     The edge phase after the first moves, carried along with EDGE_PHASE_TABLE.
+ * @param edges_all0            A boolean indicating whether all edge phases are zero.
+ * @param moves                 The serials of the first moves, at least one.
+ * @param size                  How many first moves.
+ * @param moves_map             A 2D array of moves.
+ * @param original_states       An array of original states.
+ * @param min_depth             The minimum depth of the solution.
+ * @param max_depth             The maximum depth of the solution, less than DFS_MAX_DEPTH.
+ * @param solutions             Where the solutions go.
+ * @param table                 The transition table to walk instead of the move functions, or NULL.
+ *                               When given, state is a dense index instead of a packed state.
+ * @param kernel                The generated kernel of moves_map, or NULL (ignored with a table or a prune hook).
+ * @param prune                 The hook that cuts the paths, or NULL to search every path.
+ */
+void dfs_iterator(uint64_t state, uint8_t edges_phase_state, bool edges_all0,
+                  const uint8_t* moves, uint8_t size, const Move* moves_map, const int* original_states,
+                  uint8_t min_depth, uint8_t max_depth, DfsSolutions* solutions, const MoveTable* table,
+                  const SearchKernel* kernel, const DfsPrune* prune);
 
 /**
  *                       Solves a cube using DFS algorithm.
@@ -15,6 +78,12 @@
  * and solves a cube using DFS algorithm. If the cube is solvable, print all solutions by
  * using DFS algorithm. If the cube is not solvable, print nothing.
  *
+ * With more than one thread, the paths shorter than DFS_SPLIT_DEPTH are tasks. Every thread
+ * keeps its tasks in its own deque, takes the newest one, and steals the oldest one of
+ * another thread when it runs out, so unbalanced subtrees keep every thread busy. The
+ * solutions are kept per thread and printed DFS_BUFFER_SIZE bytes at a time, so their
+ * order is not the one of a single thread.
+ *
  * @param moves                 An array of moves to use for solving the cube.
  * @param moves_map             A 2D array of moves to use for solving the cube.
  * @param original_states       An array of original states to check against.
@@ -22,7 +91,16 @@
  * @param edges_phase_state     The initial edge phase of the cube.
  * @param min_depth             The minimum depth of the solution.
  * @param max_depth             The maximum depth of the solution.
+ * @param table                 The transition table to walk instead of the move functions, or NULL.
+ * @param macros                The macro table to step by, or NULL (the macro search runs on one thread).
+ * @param automaton             The pruning automaton to step instead of moves_map, or NULL (ignored with macros).
+ * @param kernel                The generated kernel of moves_map, or NULL (ignored with a table, macros or an automaton).
+ * @param threads               How many threads search, 0 for one per CPU.
+ * @param affinity              The CPU of every thread (thread i runs on affinity[i % affinity_size]), or NULL.
+ * @param affinity_size         How many CPUs affinity holds.
  */
 void cube_dfs_solver(const Move* moves, const Move* moves_map, const int* original_states,
-                     uint32_t state, uint8_t edges_phase_state, uint8_t min_depth, uint8_t max_depth);
+                     uint32_t state, uint8_t edges_phase_state, uint8_t min_depth, uint8_t max_depth,
+                     const MoveTable* table, const MacroTable* macros, const MoveAutomaton* automaton, const SearchKernel* kernel,
+                     uint16_t threads, const int* affinity, uint8_t affinity_size);
 #endif
\ No newline at end of file
@@ -0,0 +1,116 @@
+#ifndef DISTANCE_TABLE_H
+#define DISTANCE_TABLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "move.h"
+
+#define DISTANCE_CONTEXTS 20 // the last move (R = 0 ... Dw2 = 18) or DISTANCE_START
+#define DISTANCE_START 19 // the context before the first move
+#define DISTANCE_UNKNOWN 0xf // not solvable with the moves_map, or more than DISTANCE_MAX moves
+#define DISTANCE_MAX 14 // the longest distance stored in 4 bits
+#define DISTANCE_BOTTOM_UP 2 // sweep bottom-up once the frontier holds 1 / 2 of the states not visited yet
+
+typedef struct distance_table
+{
+    bool corners_only; // edges ignored, indexed by corners_rank instead of cube_rank
+    bool edges_only; // corners ignored, indexed by edges_rank and the edge flip
+    uint32_t size; // how many ranked states per class
+    uint8_t classes; // how many distinct successor lists the contexts have
+    uint8_t class_of[DISTANCE_CONTEXTS]; // the class of every context, contexts with the same next moves share it
+    uint32_t successors[DISTANCE_CONTEXTS]; // bit m is set if move m may follow the context
+    uint8_t depth; // the longest distance found
+    uint16_t threads; // how many threads built the table
+    bool bottom_up[DISTANCE_MAX]; // bottom_up[d]: depth d + 1 was found bottom-up
+    uint32_t count[DISTANCE_MAX + 1]; // how many states are at every distance, from DISTANCE_START
+    const Move* moves_map; // the moves map the table was built for
+    uint8_t* distances; // 2 distances of 4 bits per byte, class after class
+} DistanceTable;
+
+/**
+ *                       Builds the distance of every state for a moves map.
+ *
+ * This function runs a breadth-first sweep backwards from the original states over every
+ * ranked state and stores the exact number of moves to solve it with moves_map. Only the
+ * corners are ranked when the original states ignore the edges, and only the edges (and
+ * their flip) when the original states set the corners to zero. The moves allowed depend
+ * on the last move played, so the distance is stored for every class of contexts with the
+ * same next moves.
+ *
+ * The sweep is level-synchronous over a bitmap of the frontier states, split between
+ * threads. Small frontiers are expanded top-down, from every frontier state to its
+ * predecessors. Once the frontier holds more than 1 / DISTANCE_BOTTOM_UP of the states not
+ * visited yet, every unknown state looks for a neighbour in the frontier instead. The
+ * workers never lock: distances are claimed with atomic compare-and-swap on their byte.
+ *
+ * @param table                 The table to build.
+ * @param moves_map             A 2D array of moves (19 x 19), as given to the solvers.
+ * @param original_states       The 8 original states, the edges are ignored if they are zero.
+ * @param threads               How many threads sweep the states, 0 for one per CPU.
+ *
+ * @return                      True if the table is built, false if out of memory.
+ */
+bool distance_table_create(DistanceTable* table, const Move* moves_map, const int* original_states, uint16_t threads);
+
+/**
+ *                       Frees all the memory allocated by a distance table.
+ *
+ * @param table                 The table to free.
+ */
+void distance_table_free(DistanceTable* table);
+
+/**
+ *                       Looks up the distance of a ranked state after a context.
+ *
+ * @param table                 The table to search in.
+ * @param index                 The index of the state, as built by distance_table_index.
+ * @param context               The last move played, or DISTANCE_START.
+ *
+ * @return                      The number of moves to solve the state, or DISTANCE_UNKNOWN.
+ */
+uint8_t distance_table_get(const DistanceTable* table, uint32_t index, uint8_t context);
+
+/**
+ *                       Ranks a cube the way a distance table indexes it.
+ *
+ * The pieces the table ignores are left out, so any packed state with every corner (and
+ * every edge, unless the table ranks corners only) can be looked up, the table then gives
+ * a lower bound of the moves to solve it.
+ *
+ * @param table                 The table.
+ * @param state                 The packed state.
+ * @param phase                 The edge phase, as built by edges_phase_convert (ignored if corners only).
+ *
+ * @return                      The index of the state in the table.
+ */
+uint32_t distance_table_index(const DistanceTable* table, uint32_t state, uint8_t phase);
+
+/**
+ *                       Looks up the optimal solution length of a cube.
+ *
+ * @param table                 The table to search in.
+ * @param state                 The packed state.
+ * @param phase                 The edge phase, as built by edges_phase_convert (ignored if corners only).
+ *
+ * @return                      The number of moves to solve the cube, or DISTANCE_UNKNOWN.
+ */
+uint8_t cube_distance(const DistanceTable* table, uint32_t state, uint8_t phase);
+
+/**
+ *                       Prints every optimal solution of a cube.
+ *
+ * This function descends from the cube along moves that decrease the distance by one,
+ * so every branch ends in a solution of the optimal length and nothing else is expanded.
+ * Nothing is printed if the optimal length is not within min_depth and max_depth.
+ *
+ * @param table                 The distance table of the moves map.
+ * @param state                 The initial state of the cube.
+ * @param edges_phase_state     The initial edge phase of the cube.
+ * @param min_depth             The minimum depth of the solution.
+ * @param max_depth             The maximum depth of the solution.
+ */
+void cube_distance_solver(const DistanceTable* table, uint32_t state, uint8_t edges_phase_state,
+                          uint8_t min_depth, uint8_t max_depth);
+
+#endif
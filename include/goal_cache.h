@@ -0,0 +1,67 @@
+#ifndef GOAL_CACHE_H
+#define GOAL_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bidirectional_solver.h"
+
+#define GOAL_CACHE_MAGIC 0x47333232 // "223G"
+#define GOAL_CACHE_VERSION 2
+#define GOAL_CACHE_RECORD 17 // the bytes of a stored path: key (8), steps (8) and move (1), without padding
+#define GOAL_CACHE_CHUNK 4096 // how many paths are packed or unpacked per read and write
+
+typedef struct goal_cache_header
+{
+    uint32_t magic; // GOAL_CACHE_MAGIC
+    uint32_t version; // GOAL_CACHE_VERSION, files of other versions are rebuilt
+    uint64_t signature; // the moves map and the original states the paths were expanded for
+    uint64_t sizes[BIDIRECTIONAL_MAX_DEPTH / 2 + 1]; // how many paths every level holds
+    uint8_t depth; // the longest paths stored
+} GoalCacheHeader;
+
+/**
+ *                       Hashes what the goal side of a search depends on.
+ *
+ * The backward paths only depend on the moves allowed after every move and on the
+ * original states, so two queries with the same signature can share them.
+ *
+ * @param successors            Bit m of successors[i] is set if move m may follow move i (or the start, i = 19).
+ * @param original_states       The 8 original states.
+ *
+ * @return                      The FNV-1a hash of both.
+ */
+uint64_t goal_cache_signature(const uint32_t* successors, const int* original_states);
+
+/**
+ *                       Loads the backward levels from a goal cache file.
+ *
+ * A file written for a larger depth holds the same shorter levels, so it is used too and
+ * only its levels 0 to depth are read.
+ *
+ * @param file_path             The path of the file.
+ * @param signature             The signature the levels must have been built for.
+ * @param depth                 The longest paths the levels must hold, at most the depth of the file.
+ * @param levels                Where to store levels 0 to depth, each sorted by state.
+ *
+ * @return                      True if the file exists, matches and is read, false otherwise (levels are left empty).
+ */
+bool goal_cache_load(const char* file_path, uint64_t signature, uint8_t depth, BidirectionalLevel* levels);
+
+/**
+ *                       Saves the backward levels to a goal cache file.
+ *
+ * Every path is written as a packed record of GOAL_CACHE_RECORD bytes, so the file only
+ * depends on the levels. A file of the same signature that holds longer paths is kept,
+ * as the next queries with a larger goal_depth still need it.
+ *
+ * @param file_path             The path of the file, overwritten unless it holds longer paths.
+ * @param signature             The signature the levels were built for.
+ * @param depth                 The longest paths the levels hold.
+ * @param levels                Levels 0 to depth, each sorted by state.
+ *
+ * @return                      True if the file is written or a deeper one is kept.
+ */
+bool goal_cache_save(const char* file_path, uint64_t signature, uint8_t depth, const BidirectionalLevel* levels);
+
+#endif
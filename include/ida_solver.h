@@ -0,0 +1,34 @@
+#ifndef IDA_SOLVER_H
+#define IDA_SOLVER_H
+
+#include <stdint.h>
+
+#include "API.h"
+#include "utils.h"
+#include "move.h"
+#include "distance_table.h"
+
+/**
+ *                       Solves a cube using IDA* algorithm.
+ *
+ * This function runs depth-first searches along moves_map with a growing bound on the
+ * number of moves, starting at the lower bound of the initial cube. A branch is cut as
+ * soon as its length plus the lower bound of its cube exceeds the bound. The lower bound
+ * is the largest distance of the corners and of the edges alone, looked up in their
+ * pattern databases. All the solutions of the first bound that has any are printed, so
+ * they are optimal like the BFS ones while the memory stays that of the DFS.
+ *
+ * @param moves_map             A 2D array of moves to use for solving the cube.
+ * @param original_states       An array of original states to check against.
+ * @param state                 The initial state of the cube.
+ * @param edges_phase_state     The initial edge phase of the cube.
+ * @param min_depth             The minimum depth of the solution.
+ * @param max_depth             The maximum depth of the solution.
+ * @param corners               The distance table of the corners alone.
+ * @param edges                 The distance table of the edges alone, or NULL if the edges are ignored.
+ */
+void cube_ida_solver(const Move* moves_map, const int* original_states,
+                     uint32_t state, uint8_t edges_phase_state, uint8_t min_depth, uint8_t max_depth,
+                     const DistanceTable* corners, const DistanceTable* edges);
+
+#endif
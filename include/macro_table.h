@@ -0,0 +1,60 @@
+#ifndef MACRO_TABLE_H
+#define MACRO_TABLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "move.h"
+
+#define MACRO_MAX_LENGTH 3
+#define MACRO_START 19 // the context before the first move
+#define MACRO_CONTEXTS 20 // the last move (R = 0 ... Dw2 = 18) or MACRO_START
+
+typedef struct macro
+{
+    uint8_t length; // 1 to MACRO_MAX_LENGTH moves
+    bool kept; // false if another sequence has the same net permutation, it is only walked through
+    uint8_t serials[MACRO_MAX_LENGTH];
+    uint32_t next; // the index of the next macro that does not extend this one
+} Macro;
+
+typedef struct macro_table
+{
+    uint8_t length; // the search steps by macros of this many moves
+    Move moves[19]; // the moves of moves_map by serial, to apply the macros
+    uint32_t sequences[MACRO_MAX_LENGTH]; // allowed sequences of 1 to length moves, all contexts together
+    uint32_t distinct[MACRO_MAX_LENGTH]; // how many of them are kept
+    uint32_t size[MACRO_CONTEXTS]; // how many macros follow each context
+    Macro* macros[MACRO_CONTEXTS]; // the macros of each context, depth first in moves_map order
+} MacroTable;
+
+/**
+ *                       Builds the macro moves of up to a given length.
+ *
+ * This function enumerates, for every context (the last move played, or MACRO_START),
+ * every sequence of 1 to length moves allowed by moves_map, and keeps the first one (in
+ * moves_map order) of every distinct net permutation. Two sequences are only merged if
+ * their last moves allow the same next moves, so stepping by macros reaches every state
+ * the plain sequences reach. When edges_all0 is true, only the corner permutation counts.
+ *
+ * The macros of a context are stored depth first, a sequence right before its extensions,
+ * so a search walks them like a tree and applies one move per macro. Sequences that are
+ * not kept stay in the list when a kept sequence extends them.
+ *
+ * @param table                 The table to build.
+ * @param moves_map             A 2D array of moves (19 x 19), as given to the solvers.
+ * @param length                The longest macros, 1 to MACRO_MAX_LENGTH.
+ * @param edges_all0            A boolean indicating whether the edges are ignored.
+ *
+ * @return                      True if the table is built, false if out of memory.
+ */
+bool macro_table_create(MacroTable* table, const Move* moves_map, uint8_t length, bool edges_all0);
+
+/**
+ *                       Frees all the memory allocated by a macro table.
+ *
+ * @param table                 The table to free.
+ */
+void macro_table_free(MacroTable* table);
+
+#endif
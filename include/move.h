@@ -67,6 +67,27 @@ uint32_t F_transform(uint32_t state);
  */
 uint32_t B_transform(uint32_t state);
 
+/**
+ * *_transform_bmi2: BMI2 versions of R_transform, L_transform, F_transform and B_transform
+ *
+ * Same results as the scalar functions, the moved fields are gathered with pext and
+ * scattered back with pdep. Only call them if move_bmi2_supported() returns true.
+ *
+ * @state:                      32-bit representation of corner and edge phases
+ * @return:                     transformed corner and edge phases
+ */
+uint32_t R_transform_bmi2(uint32_t state);
+uint32_t L_transform_bmi2(uint32_t state);
+uint32_t F_transform_bmi2(uint32_t state);
+uint32_t B_transform_bmi2(uint32_t state);
+
+/**
+ * move_bmi2_supported: checks if the CPU can run the *_transform_bmi2 functions
+ *
+ * @return:                     true if BMI2 is available, false otherwise
+ */
+bool move_bmi2_supported();
+
 /**
  * U_transform: corner phase check for U move
  * corners: 0123 4567 => 0653 4217, edges: 0123 => 0213
@@ -353,6 +374,38 @@ uint8_t edge_B_transform(uint8_t state);
  */
 uint8_t edge_R_transform(uint8_t state);
 
+/**
+ * edge_transform: edge phase check for any move
+ *
+ * @state:                      8-bit representation of edge phase
+ * @serial:                     the serial of the move (R = 0 ... Dw2 = 18)
+ * @return:                     transformed edge phase
+ *
+ * U and D moves do not change the edge phase, the wide moves change it like
+ * the E move they contain (Dw turns the middle layer like E').
+ */
+uint8_t edge_transform(uint8_t state, uint8_t serial);
+
+// EDGE_PHASE_TABLE[serial][phase]: the edge phase after the move, see edge_phase_table_init
+extern uint8_t EDGE_PHASE_TABLE[19][256];
+
+/**
+ * edge_phase_table_init: fills EDGE_PHASE_TABLE
+ *
+ * EDGE_PHASE_TABLE[serial][phase] is edge_transform(phase, serial), so the solvers can
+ * carry the edge phase along a path with one lookup per move instead of replaying the
+ * whole path. Calling it again does nothing.
+ */
+void edge_phase_table_init();
+
+/**
+ * edge_phase_solved: checks if an edge phase is solved
+ *
+ * @phase:                      8-bit representation of edge phase
+ * @return:                     true if the phase is 3 or one of its E turns
+ */
+bool edge_phase_solved(uint8_t phase);
+
 extern const Move R;
 extern const Move L;
 extern const Move F;
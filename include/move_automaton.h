@@ -0,0 +1,70 @@
+#ifndef MOVE_AUTOMATON_H
+#define MOVE_AUTOMATON_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "move.h"
+
+#define AUTOMATON_MAX_LENGTH 5 // the longest sequences compared
+#define AUTOMATON_START 0 // the state before the first move
+
+typedef struct move_automaton
+{
+    uint8_t length; // sequences of up to this many moves are compared
+    Move moves[19]; // the moves of moves_map by serial, to apply the transitions
+    uint32_t size; // how many states
+    uint32_t* first; // the transitions of state s are first[s] ... first[s + 1] - 1, in moves_map order
+    uint8_t* serials; // the move of every transition
+    uint32_t* targets; // the state after every transition
+    bool* accepting; // accepting[s]: true if a path ending in state s may be a solution, NULL if every state is
+    uint32_t nodes; // how many sequences were kept while building, all contexts together
+    uint64_t sequences[AUTOMATON_MAX_LENGTH]; // sequences[l]: the paths of l + 1 moves moves_map allows
+    uint64_t kept[AUTOMATON_MAX_LENGTH]; // kept[l]: how many of them the automaton allows
+} MoveAutomaton;
+
+/**
+ *                       Builds the automaton that only allows the first of every redundant sequence.
+ *
+ * This function enumerates, for every context (the last move played, or the start of the
+ * path), the sequences of 1 to length moves allowed by moves_map, shortest first and in
+ * moves_map order, and hashes the net permutation of every one. A sequence is forbidden
+ * if an earlier one of the same context has the same net permutation and its last move
+ * allows the same next moves, as the earlier one can replace it in any path. The earlier
+ * one may be shorter, down to no move at all. When edges_all0 is true, only the corner
+ * permutation counts.
+ *
+ * A path is allowed if none of its sequences of up to length moves is forbidden. The
+ * states of the automaton are the last moves of a path that still matter, so stepping it
+ * replaces the moves_map row of the last move. Every cube keeps its first shortest path,
+ * so the shortest solution length does not change.
+ *
+ * @param automaton             The automaton to build.
+ * @param moves_map             A 2D array of moves (19 x 19), as given to the solvers.
+ * @param length                The longest sequences compared, 1 to AUTOMATON_MAX_LENGTH.
+ * @param edges_all0            A boolean indicating whether the edges are ignored.
+ *
+ * @return                      True if the automaton is built, false if out of memory.
+ */
+bool move_automaton_create(MoveAutomaton* automaton, const Move* moves_map, uint8_t length, bool edges_all0);
+
+/**
+ *                       Counts the paths of every length moves_map and an automaton allow.
+ *
+ * Fills sequences and kept, for paths of 1 to AUTOMATON_MAX_LENGTH moves from the start.
+ *
+ * @param automaton             The automaton, with its transitions.
+ * @param moves_map             A 2D array of moves (19 x 19), the one the automaton is built from.
+ *
+ * @return                      False if out of memory.
+ */
+bool move_automaton_count(MoveAutomaton* automaton, const Move* moves_map);
+
+/**
+ *                       Frees all the memory allocated by an automaton.
+ *
+ * @param automaton             The automaton to free.
+ */
+void move_automaton_free(MoveAutomaton* automaton);
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef CUBE_MOVE_BITSLICE_H
+#define CUBE_MOVE_BITSLICE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define BITSLICE_WORDS 4 // 64 bit words per plane
+#define BITSLICE_LANES (BITSLICE_WORDS * 64) // how many states a slice holds
+
+typedef struct bit_slice
+{
+    uint64_t planes[32][BITSLICE_WORDS]; // planes[p] holds one bit of every state, lane i is bit i % 64 of word i / 64
+    uint8_t map[32]; // bit k of the packed states lives in planes[map[k]]
+} BitSlice;
+
+/**
+ *                       Builds the plane permutation of every move.
+ *
+ * Every move only moves bits of the packed state around, this function records where
+ * each bit goes. It is called by the other bitslice functions when needed.
+ */
+void bitslice_init();
+
+/**
+ *                       Transposes packed states into a bit-sliced batch.
+ *
+ * @param slice                 The slice to fill.
+ * @param states                The packed states, lane i gets states[i].
+ * @param n                     How many states, at most BITSLICE_LANES, the other lanes are zeroed.
+ */
+void bitslice_transpose_in(BitSlice* slice, const uint32_t* states, size_t n);
+
+/**
+ *                       Transposes a bit-sliced batch back into packed states.
+ *
+ * @param slice                 The slice to read.
+ * @param states                Where to store the packed states, states[i] gets lane i.
+ * @param n                     How many lanes to read, at most BITSLICE_LANES.
+ */
+void bitslice_transpose_out(const BitSlice* slice, uint32_t* states, size_t n);
+
+/**
+ *                       Applies a move to every lane of a slice.
+ *
+ * Only the bit => plane map is rewritten (32 bytes), the planes themselves are never
+ * touched, so the cost does not depend on the number of lanes.
+ *
+ * @param slice                 The slice to transform.
+ * @param serial                The serial of the move (R = 0 ... Dw2 = 18).
+ */
+void bitslice_apply(BitSlice* slice, uint8_t serial);
+
+/**
+ *                       Applies a sequence of moves to every lane of a slice.
+ *
+ * @param slice                 The slice to transform.
+ * @param serials               The serials of the moves, in order.
+ * @param size                  How many moves.
+ */
+void bitslice_apply_sequence(BitSlice* slice, const uint8_t* serials, size_t size);
+
+/**
+ *                       Checks every lane of a slice against the original states.
+ *
+ * @param slice                 The slice to check.
+ * @param original_states       An array of 8 original states to check against.
+ * @param hits                  Where to store the result, bit i % 64 of hits[i / 64] is set if lane i is an original state.
+ */
+void bitslice_original_state(const BitSlice* slice, const int* original_states, uint64_t hits[BITSLICE_WORDS]);
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef MOVE_CANONICAL_H
+#define MOVE_CANONICAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "move.h"
+
+#define CANONICAL_ELEMENTS 256 // the most cubes the moves of a commuting class may reach from the solved cube
+#define CANONICAL_MAX_LENGTH 64 // runs of commuting moves are compared up to this length, the longest path a search holds
+
+typedef struct canonical_stats
+{
+    uint8_t classes; // how many classes of at least 2 moves commute with each other
+    uint8_t class_of[19]; // the class of every move, 0xff if it commutes with no move
+    uint16_t both_orders; // how many successors are a move of the same class allowed in both orders
+    uint16_t removed; // how many successors are removed
+} CanonicalStats;
+
+/**
+ *                       Checks if two moves commute.
+ *
+ * The moves commute if playing them in either order gives the same packed state and the
+ * same edge phase from any cube. Both only permute the fields of the state, so applying
+ * them to a state with a different piece on every position is enough.
+ *
+ * @param a                     The first move.
+ * @param b                     The second move.
+ *
+ * @return                      True if a then b is always b then a.
+ */
+bool moves_commute(const Move* a, const Move* b);
+
+/**
+ *                       Tightens a moves map to one ordering of commuting moves.
+ *
+ * The moves are split into classes of moves that all commute with each other, and every
+ * path into runs of moves of one class. A run only counts by its length, by the cube it
+ * reaches, by the moves allowed before its first move and by the moves allowed after its
+ * last one: any other run that matches them can replace it in a path.
+ *
+ * The successors of a move that have a lower serial and are in its class are tried in
+ * turn: one is removed if every run of the original moves_map is still matched by a run of
+ * the tightened one. Orders like "D U" go first, so the ascending order of every commuting
+ * block is the one kept when both are allowed. Every cube keeps a path of every length it
+ * had, so the shortest solution length does not change, while the searches skip the runs
+ * that only repeat another one.
+ *
+ * @param moves_map             A 2D array of moves (19 x 19), as given to the solvers. The rows are compacted in place.
+ * @param stats                 Where to store the classes and count the removed successors, or NULL.
+ *
+ * @return                      How many successors are removed, 0 if out of memory.
+ */
+uint16_t moves_map_canonical(Move* moves_map, CanonicalStats* stats);
+
+#endif
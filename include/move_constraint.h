@@ -0,0 +1,70 @@
+#ifndef MOVE_CONSTRAINT_H
+#define MOVE_CONSTRAINT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "move.h"
+#include "move_automaton.h"
+
+#define CONSTRAINT_MAX_SIZE 8 // the most patterns a solve can give
+#define CONSTRAINT_MAX_NFA 1024 // the most states a pattern compiles to before determinizing
+#define CONSTRAINT_MAX_STATES 4096 // the most states of the automaton of a pattern
+#define CONSTRAINT_MAX_REPEAT 32 // the largest count of a {n,m} repetition
+#define CONSTRAINT_MAX_PRODUCT 1048576 // the most states of the product with moves_map
+
+typedef struct move_constraint
+{
+    bool negated; // the pattern starts with '!', the solutions must not match it
+    uint16_t size; // how many states, the start state is 0
+    int16_t* next; // next[s * 19 + m]: the state after move m from state s, every move is defined
+    bool* accepting; // accepting[s]: true if a path ending in state s matches the pattern
+} MoveConstraint;
+
+/**
+ *                       Compiles a pattern over move symbols.
+ *
+ * A pattern matches whole solutions. It is made of move symbols (R, U', Dw2, ...), '.' for
+ * any move, sets of moves like [U U' U2] or [^F], groups in parentheses, the alternation
+ * '|' and the repetitions '*', '+', '?', '{n}', '{n,}' and '{n,m}'. Spaces are ignored,
+ * "R U" and "RU" are the same. A leading '!' negates the pattern. For example ".* R" only
+ * lets the solutions that end with R through, "!(.* F){3} .*" the ones with at most two F,
+ * and "[U U' U2] .*" the ones that start with a U turn.
+ *
+ * The pattern is compiled into a deterministic automaton over the 19 moves, every state
+ * of which has a transition for every move.
+ *
+ * @param constraint            The constraint to build.
+ * @param pattern               The pattern.
+ * @param error                 Where to write why the pattern is invalid, 128 bytes.
+ *
+ * @return                      True if compiled, false if invalid or out of memory.
+ */
+bool move_constraint_compile(MoveConstraint* constraint, const char* pattern, char* error);
+
+/**
+ *                       Frees all the memory allocated by a constraint.
+ *
+ * @param constraint            The constraint to free.
+ */
+void move_constraint_free(MoveConstraint* constraint);
+
+/**
+ *                       Builds the product of moves_map and constraints.
+ *
+ * The states of the product are a last move (or the start of the path) and a state of
+ * every constraint. A state is accepting if every constraint accepts, and the states from
+ * which no accepting state can be reached are removed with the transitions into them, so
+ * a search stepping the product never enters a branch without a solution allowed by the
+ * constraints. The transitions keep the moves_map order.
+ *
+ * @param automaton             The automaton to build, its accepting array is set.
+ * @param moves_map             A 2D array of moves (19 x 19), as given to the solvers.
+ * @param constraints           The compiled constraints.
+ * @param size                  How many constraints, 1 to CONSTRAINT_MAX_SIZE.
+ *
+ * @return                      True if built, false if out of memory or more than CONSTRAINT_MAX_PRODUCT states.
+ */
+bool move_automaton_constrain(MoveAutomaton* automaton, const Move* moves_map, const MoveConstraint* constraints, uint8_t size);
+
+#endif
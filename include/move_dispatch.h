@@ -0,0 +1,47 @@
+#ifndef CUBE_MOVE_DISPATCH_H
+#define CUBE_MOVE_DISPATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "move.h"
+#include "move_simd.h"
+
+/**
+ *                       Detects the CPU features and picks the fastest kernel of every move.
+ *
+ * Every move has a scalar kernel, the face moves (R, L, F, B) also have a BMI2 kernel and
+ * every move has an AVX2 batch kernel. The kernels the CPU supports are timed on a short
+ * chain of calls and the fastest one is kept. Only the first call does the work, the
+ * result is shared by the whole program.
+ */
+void move_dispatch_init();
+
+/**
+ *                       Replaces the move functions with the fastest kernels.
+ *
+ * @param moves                 The moves to rebind, the kernel is chosen by serial, EMPTY moves are kept.
+ * @param size                  How many moves.
+ */
+void move_dispatch_bind(Move* moves, uint8_t size);
+
+/**
+ *                       Returns the fastest batch kernel of a move.
+ *
+ * @param serial                The serial of the move (R = 0 ... Dw2 = 18).
+ *
+ * @return                      The AVX2 kernel, or a scalar loop if it is faster or AVX2 is missing.
+ */
+BatchTransform move_dispatch_batch(uint8_t serial);
+
+/**
+ *                       Returns the name of the kernel bound to a move.
+ *
+ * @param serial                The serial of the move (R = 0 ... Dw2 = 18).
+ * @param batch                 True for the batch kernel, false for the single state kernel.
+ *
+ * @return                      "scalar", "bmi2" or "avx2".
+ */
+const char* move_dispatch_name(uint8_t serial, bool batch);
+
+#endif
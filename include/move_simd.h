@@ -0,0 +1,71 @@
+#ifndef CUBE_MOVE_SIMD_H
+#define CUBE_MOVE_SIMD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef void (*BatchTransform)(const uint32_t* in, uint32_t* out, size_t n);
+
+/**
+ *                       Checks if the CPU can run the AVX2 batch kernels.
+ *
+ * The *_x8 functions fall back to the scalar move functions when AVX2 is missing,
+ * this only tells the callers whether batching is worth it.
+ *
+ * @return                      True if AVX2 is available, false otherwise.
+ */
+bool move_simd_supported();
+
+/**
+ * *_transform_x8: batch versions of the move functions in move.h
+ *
+ * Each function applies its move to n packed states, 8 states per AVX2 instruction,
+ * the remainder (n % 8) goes through the scalar move function. in and out may be the
+ * same array.
+ *
+ * @in:                         n packed states
+ * @out:                        where to store the n transformed states
+ * @n:                          how many states to transform
+ */
+void R_transform_x8(const uint32_t* in, uint32_t* out, size_t n);
+void L_transform_x8(const uint32_t* in, uint32_t* out, size_t n);
+void F_transform_x8(const uint32_t* in, uint32_t* out, size_t n);
+void B_transform_x8(const uint32_t* in, uint32_t* out, size_t n);
+void U_transform_x8(const uint32_t* in, uint32_t* out, size_t n);
+void UPrime_transform_x8(const uint32_t* in, uint32_t* out, size_t n);
+void U2_transform_x8(const uint32_t* in, uint32_t* out, size_t n);
+void E_transform_x8(const uint32_t* in, uint32_t* out, size_t n);
+void EPrime_transform_x8(const uint32_t* in, uint32_t* out, size_t n);
+void E2_transform_x8(const uint32_t* in, uint32_t* out, size_t n);
+void D_transform_x8(const uint32_t* in, uint32_t* out, size_t n);
+void DPrime_transform_x8(const uint32_t* in, uint32_t* out, size_t n);
+void D2_transform_x8(const uint32_t* in, uint32_t* out, size_t n);
+void Uw_transform_x8(const uint32_t* in, uint32_t* out, size_t n);
+void UwPrime_transform_x8(const uint32_t* in, uint32_t* out, size_t n);
+void Uw2_transform_x8(const uint32_t* in, uint32_t* out, size_t n);
+void Dw_transform_x8(const uint32_t* in, uint32_t* out, size_t n);
+void DwPrime_transform_x8(const uint32_t* in, uint32_t* out, size_t n);
+void Dw2_transform_x8(const uint32_t* in, uint32_t* out, size_t n);
+
+/**
+ *                       Batch kernels indexed by move serial (R = 0 ... Dw2 = 18).
+ */
+extern const BatchTransform BATCH_TRANSFORMS[19];
+
+/**
+ *                       Checks a batch of states against the original states.
+ *
+ * This is the batch version of is_original_state, each state is compared against all
+ * 8 original states at once.
+ *
+ * @param states                n packed states to check.
+ * @param n                     How many states to check.
+ * @param original_states       An array of 8 original states to check against.
+ * @param hits                  Where to store the result, hits[i] is true if states[i] is an original state.
+ *
+ * @return                      How many states are original states.
+ */
+size_t is_original_state_x8(const uint32_t* states, size_t n, const int* original_states, bool* hits);
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef MOVE_TABLE_H
+#define MOVE_TABLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "move.h"
+
+#define MOVE_TABLE_MOVES 19
+
+typedef struct move_table
+{
+    bool corners_only; // edges ignored, indexed by corners_rank instead of cube_state_rank
+    bool symmetric; // only the representatives of the symmetry classes are indexed
+    uint32_t size; // how many reachable states are indexed
+    uint32_t* states; // dense index => packed state
+    uint32_t* next_state; // next_state[index * MOVE_TABLE_MOVES + serial] => dense index (<< 4 | symmetry if symmetric)
+} MoveTable;
+
+/**
+ *                       Builds the transition table of all reachable states.
+ *
+ * This function indexes every state reachable from the original states with the 19
+ * moves of the 223 cube by its rank (corners only when the original states ignore the
+ * edges) and stores, for every index and every move, the index of the resulting state.
+ * Solvers can then walk the table instead of calling the move functions.
+ *
+ * A symmetric table only indexes the representatives picked by cube_canonical, about 16
+ * times fewer states. Its indices carry the symmetry from the walked state to the
+ * representative in their 4 lowest bits, see move_table_next.
+ *
+ * @param table                 The table to build.
+ * @param original_states       The 8 original states, only used to tell if the edges are ignored.
+ * @param symmetric             Index the symmetry classes instead of the states.
+ *
+ * @return                      True if the table is built, false if out of memory.
+ */
+bool move_table_create(MoveTable* table, const int* original_states, bool symmetric);
+
+/**
+ *                       Frees all the memory allocated by a transition table.
+ *
+ * @param table                 The table to free.
+ */
+void move_table_free(MoveTable* table);
+
+/**
+ *                       Looks up the dense index of a packed state.
+ *
+ * @param table                 The table to search in.
+ * @param state                 The packed state to look up.
+ *
+ * @return                      The dense index of the state, or -1 if the state is not a legal cube.
+ */
+int64_t move_table_index(const MoveTable* table, uint32_t state);
+
+/**
+ *                       Applies a move to a dense index.
+ *
+ * @param table                 The table to walk.
+ * @param index                 The dense index, from move_table_index or move_table_next.
+ * @param serial                The serial of the move (R = 0 ... Dw2 = 18).
+ *
+ * @return                      The dense index of the new state.
+ */
+uint32_t move_table_next(const MoveTable* table, uint32_t index, uint8_t serial);
+
+/**
+ *                       Looks up the packed state of a dense index.
+ *
+ * The packed state of a symmetric table is the representative of the class, it is solved
+ * exactly when the walked state is.
+ *
+ * @param table                 The table to search in.
+ * @param index                 The dense index.
+ *
+ * @return                      The packed state.
+ */
+uint32_t move_table_state(const MoveTable* table, uint32_t index);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef SEARCH_KERNEL_H
+#define SEARCH_KERNEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "move.h"
+
+#define KERNEL_MAX_DEPTH 64 // the longest path a kernel search can hold
+
+typedef struct kernel_search KernelSearch;
+
+struct kernel_search
+{
+    const int* original_states;
+    bool edges_all0;
+    uint8_t min_depth;
+    uint8_t max_depth; // less than KERNEL_MAX_DEPTH
+    uint8_t path[KERNEL_MAX_DEPTH]; // the serials of the moves played
+    void (*report)(KernelSearch* search, uint8_t size); // called with every solution, the moves are in path
+    void* data; // given to report
+};
+
+typedef struct search_kernel
+{
+    const char* name; // the settings file the kernel is generated from
+    uint8_t successors[19][19]; // successors[m]: the serials of the moves allowed after move m, in moves_map order
+    uint8_t successors_size[19];
+
+    /**
+     * Searches every path that extends search -> path, the first depth moves of which are
+     * played and lead to state, which is neither solved nor at max_depth.
+     */
+    void (*dfs)(KernelSearch* search, uint32_t state, uint8_t phase, uint8_t depth);
+
+    /**
+     * Applies every move allowed after last_move to state and phase, in moves_map order.
+     * Returns how many states, phases and serials are written (at most 18).
+     */
+    uint8_t (*expand)(uint32_t state, uint8_t phase, uint8_t last_move, uint32_t* states, uint8_t* phases, uint8_t* serials);
+} SearchKernel;
+
+// the kernels generated at build time by search_kernel_gen, one per settings file
+extern const SearchKernel SEARCH_KERNELS[];
+extern const uint8_t SEARCH_KERNELS_SIZE;
+
+/**
+ *                       Finds the generated kernel of a moves map.
+ *
+ * A kernel matches if every row of moves_map allows the same moves after its move, in the
+ * same order, as the settings file it was generated from, so it finds the same solutions
+ * in the same order as the generic search.
+ *
+ * @param moves_map             A 2D array of moves (19 x 19), as given to the solvers.
+ *
+ * @return                      The kernel, or NULL if no settings file had this moves map.
+ */
+const SearchKernel* search_kernel_find(const Move* moves_map);
+
+#endif
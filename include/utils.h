@@ -16,14 +16,15 @@
 void my_itoa(int num, char* str, int base);
 
 /**
- * Reads the contents of a file into a given string. The string is not
- * necessarily null-terminated, but the last character will be set to '\0' to
- * make it null-terminated.
+ * Reads the contents of a file into a new string. The string is allocated to
+ * the size of the file and null-terminated, so files of any size fit.
  *
- * @param result The string to store the result in.
  * @param file_path The path to the file to read from.
+ *
+ * @return The contents of the file, to be freed by the caller, or NULL if the
+ *         file cannot be read.
  */
-void read_from_file(char* result, const char* file_path);
+char* read_from_file(const char* file_path);
 
 /**
  * Checks if a state is one of the original states.
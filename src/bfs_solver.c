@@ -1,210 +1,831 @@
 #include <stdint.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
 
 #include "bfs_solver.h"
+#include "utils.h"
+#include "move_simd.h"
+#include "move_dispatch.h"
+#include "cube_rank.h"
+#include "cube_symmetry.h"
 
 /**
- * Allocate a new Node and optionally link it to a parent.
+ *                       Formats the steps required to solve a cube.
  *
- * @param parrent               Node to link to, or NULL if this Node is to be the head of a list.
+ * @param string                Where to write the string, 1024 bytes.
+ * @param map                   An array of moves to use for looking up move names.
+ * @param path                  The serials of the moves, the first one first.
+ * @param size                  The number of moves in the sequence.
+ */
+void bfs_format_path(char* string, const Move* map, const uint8_t* path, uint8_t size)
+{
+    strcpy(string, "steps: \0");
+
+    for (uint8_t i = 0; i < size; i++)
+    {
+        strcat(string, map[path[i]].symbol);
+        strcat(string, "\t");
+    }
+}
+
+typedef struct bfs_level
+{
+    Move (*moves_map_2d)[19]; // row i lists the moves allowed after move i
+    const int* original_states;
+    const MoveTable* table; // NULL if the nodes hold packed states
+    const Move* all_moves; // all moves indexed by serial, to print the solutions
+    bool edges_all0;
+    bool simd; // expand block by block with the batch move kernels
+    const SearchKernel* kernel; // expands the nodes with the generated kernel of moves_map, NULL if none
+    const MoveAutomaton* automaton; // expands the nodes with the transitions of their automaton state, NULL if none
+    uint8_t depth; // how many moves the paths of the frontier hold
+    uint8_t max_depth;
+    uint8_t classes; // how many distinct successor lists the moves have
+    uint8_t class_of[19]; // the class of every last move, moves with the same next moves share it
+    uint32_t ranks; // how many ranked states per class
+    BfsFrontier** levels; // levels[d]: the nodes of depth d, as output by the workers of the level before
+    uint16_t* levels_size; // levels_size[d]: how many parts levels[d] is made of
+    uint64_t* visited; // bit (rank * classes + class) is set once a state is queued, NULL if no deduplication
+    bool all; // BFS_DEDUP_ALL: the nodes are merged, the paths into them are kept in parents
+    BfsParents* parents; // parents[d]: the paths into every node of depth d, BFS_DEDUP_ALL only
+} BfsLevel;
+
+typedef struct bfs_worker
+{
+    const BfsLevel* level;
+    uint64_t begin; // the first frontier node to expand
+    uint64_t end; // after the last frontier node to expand
+    BfsFrontier next; // the nodes of the next level found by this worker
+    char* text; // the solutions found by this worker, printed in worker order after the level
+    size_t text_size;
+    size_t text_capacity;
+    uint32_t solution_count;
+    bool failed; // out of memory
+} BfsWorker;
+
+/**
+ *                       Appends a node to a frontier.
+ *
+ * @param frontier              The frontier, grown by doubling when full.
+ * @param state                 The state of the node.
+ * @param phase                 The edge phase of the node.
+ * @param parent                The index of the parent of the node in its level.
+ * @param move                  The last move of the node.
+ * @param context               The automaton state of the node, BFS_NO_CONTEXT without an automaton.
+ *
+ * @return                      False if out of memory.
+ */
+static bool bfs_frontier_push(BfsFrontier* frontier, uint32_t state, uint8_t phase, uint32_t parent, uint8_t move, uint32_t context)
+{
+    if (frontier -> size == frontier -> capacity)
+    {
+        const size_t capacity = frontier -> capacity == 0 ? 1024 : frontier -> capacity * 2;
+        uint32_t* states = (uint32_t*)(realloc(frontier -> states, capacity * sizeof(uint32_t)));
+
+        if (states != NULL)
+            frontier -> states = states;
+
+        uint8_t* phases = (uint8_t*)(realloc(frontier -> phases, capacity * sizeof(uint8_t)));
+
+        if (phases != NULL)
+            frontier -> phases = phases;
+
+        uint32_t* parents = (uint32_t*)(realloc(frontier -> parents, capacity * sizeof(uint32_t)));
+
+        if (parents != NULL)
+            frontier -> parents = parents;
+
+        uint8_t* moves = (uint8_t*)(realloc(frontier -> moves, capacity * sizeof(uint8_t)));
+
+        if (moves != NULL)
+            frontier -> moves = moves;
+
+        uint32_t* contexts = context == BFS_NO_CONTEXT ? NULL : (uint32_t*)(realloc(frontier -> contexts, capacity * sizeof(uint32_t)));
+
+        if (contexts != NULL)
+            frontier -> contexts = contexts;
+
+        if (states == NULL || phases == NULL || parents == NULL || moves == NULL || (context != BFS_NO_CONTEXT && contexts == NULL))
+            return false;
+
+        frontier -> capacity = capacity;
+    }
+
+    frontier -> states[frontier -> size] = state;
+    frontier -> phases[frontier -> size] = phase;
+    frontier -> parents[frontier -> size] = parent;
+
+    if (context != BFS_NO_CONTEXT)
+        frontier -> contexts[frontier -> size] = context;
+
+    frontier -> moves[frontier -> size++] = move;
+
+    return true;
+}
+
+/**
+ *                       Frees all the memory allocated by a frontier.
+ *
+ * @param frontier              The frontier to free.
+ */
+static void bfs_frontier_free(BfsFrontier* frontier)
+{
+    free(frontier -> states);
+    free(frontier -> phases);
+    free(frontier -> parents);
+    free(frontier -> moves);
+    free(frontier -> contexts);
+    *frontier = (BfsFrontier){0};
+}
+
+/**
+ *                       Frees the states of a frontier, keeping the paths into its nodes.
+ *
+ * @param frontier              The frontier, once expanded.
+ */
+static void bfs_frontier_shrink(BfsFrontier* frontier)
+{
+    free(frontier -> states);
+    free(frontier -> phases);
+    free(frontier -> contexts);
+    frontier -> states = NULL;
+    frontier -> phases = NULL;
+    frontier -> contexts = NULL;
+}
+
+/**
+ *                       Looks up the packed state of a node.
+ *
+ * @param level                 The level being expanded.
+ * @param state                 The state of the node, a dense index when walking a transition table.
+ *
+ * @return                      The packed state of the cube, not its symmetry representative.
+ */
+static uint32_t bfs_packed_state(const BfsLevel* level, uint32_t state)
+{
+    if (level -> table == NULL)
+        return state;
+
+    const uint32_t packed = move_table_state(level -> table, state);
+
+    // the 4 lowest bits hold the symmetry from the cube to its representative
+    return level -> table -> symmetric ? cube_conjugate(packed, CUBE_SYMMETRY[state & 0xf].inverse) : packed;
+}
+
+/**
+ *                       Builds the key of a node in the visited bitmap.
+ *
+ * @param level                 The level being expanded.
  * @param state                 The state of the node.
- * @param steps                 The number of steps of the node.
- * @param steps_size            The number of steps size of the node.
+ * @param phase                 The edge phase of the node.
+ * @param serial                The last move of the node.
  *
- * @return                      The newly allocated Node.
+ * @return                      The rank of the state (and its edge flip), then the class of the last move.
  */
-Node* node_create(Node* parrent, uint32_t state, uint64_t steps, uint8_t steps_size)
+static uint64_t bfs_key(const BfsLevel* level, uint32_t state, uint8_t phase, uint8_t serial)
 {
-    Node* node = (Node*)(malloc(sizeof(Node)));
+    const uint32_t packed = bfs_packed_state(level, state);
+    const uint32_t rank = level -> edges_all0 ? corners_rank(packed) : cube_rank(packed, phase);
+
+    return (uint64_t)(rank) * level -> classes + level -> class_of[serial];
+}
 
-    node -> next = NULL;
-    node -> state = state;
-    node -> steps = steps;
-    node -> steps_size = steps_size;
+/**
+ *                       Marks a node as visited in the shared bitmap.
+ *
+ * The moves allowed next depend on the last move, so a state is only a duplicate of a
+ * state reached after a move of the same class. Threads never lock: the bit is set with
+ * an atomic fetch-or, and exactly one of the threads setting it sees it clear. With
+ * BFS_DEDUP_ALL, the bitmap only holds the previous levels and is not written.
+ *
+ * @param level                 The level being expanded.
+ * @param state                 The state of the node.
+ * @param phase                 The edge phase of the node.
+ * @param serial                The last move of the node.
+ *
+ * @return                      True if the node was not visited before.
+ */
+static bool bfs_visit(const BfsLevel* level, uint32_t state, uint8_t phase, uint8_t serial)
+{
+    const uint64_t key = bfs_key(level, state, phase, serial);
+    const uint64_t bit = 1ull << (key & 63);
 
-    if (parrent != NULL)
-        parrent -> next = node;
+    // every path reaching a new node is kept until the level is merged
+    if (level -> all)
+        return !(level -> visited[key / 64] & bit);
 
-    return node;
+    return !(__atomic_fetch_or(level -> visited + key / 64, bit, __ATOMIC_RELAXED) & bit);
 }
 
 /**
- *                       Prints the contents of a queue as a linked list.
+ *                       Queues a node of the next level, unless it is a duplicate.
  *
- * This is a debugging function that prints the contents of a queue as a linked list.
- * Each node is printed as a pointer address, and the list is terminated with a newline.
+ * @param worker                The worker.
+ * @param state                 The state of the node.
+ * @param phase                 The edge phase of the node.
+ * @param parent                The index of the parent of the node in its level.
+ * @param serial                The last move of the node.
+ * @param context               The automaton state of the node, BFS_NO_CONTEXT without an automaton.
+ */
+static void bfs_worker_push(BfsWorker* worker, uint32_t state, uint8_t phase, uint32_t parent, uint8_t serial, uint32_t context)
+{
+    if (worker -> level -> visited != NULL && !bfs_visit(worker -> level, state, phase, serial))
+        return;
+
+    if (!bfs_frontier_push(&worker -> next, state, phase, parent, serial, context))
+        worker -> failed = true;
+}
+
+/**
+ *                       Appends a solution to the buffer of a worker.
  *
- * @param queue                 The queue to print.
+ * @param worker                The worker.
+ * @param string                The solution, as built by bfs_format_path.
  */
-void queue_print(Queue* queue)
+static void bfs_worker_append(BfsWorker* worker, const char* string)
 {
-    Node* node = queue -> head;
+    const size_t size = strlen(string);
 
-    while (node != NULL)
+    if (worker -> text_size + size + 2 > worker -> text_capacity)
     {
-        printf("%p -> ", node);
-        node = node -> next;
+        const size_t capacity = worker -> text_capacity == 0 ? 4096 : worker -> text_capacity * 2 + size;
+        char* text = (char*)(realloc(worker -> text, capacity));
+
+        if (text == NULL)
+        {
+            worker -> failed = true;
+            return;
+        }
+
+        worker -> text = text;
+        worker -> text_capacity = capacity;
     }
 
-    puts("\0");
+    memcpy(worker -> text + worker -> text_size, string, size);
+    worker -> text_size += size;
+    worker -> text[worker -> text_size++] = '\n';
+    worker -> solution_count++;
 }
 
 /**
- *                       Adds a new node to the head of the queue (only can use when queue is empty !!!).
+ *                       Appends every path into a node to the buffer of a worker.
  *
- * This function creates a new node with the given state, steps, and steps_size,
- * and sets it as the head of the queue. The new node also becomes the last node
- * in the queue, and the queue size is set to 1.
+ * This function walks the parents of the node back to the first level, the moves are
+ * written from the last one to the first one.
  *
- * @param queue                 The queue to which the new node is added.
- * @param state                 The state of the new node.
- * @param steps                 The number of steps of the new node.
- * @param steps_size            The number of steps size of the new node.
+ * @param worker                The worker.
+ * @param depth                 The depth of the node.
+ * @param node                  The index of the node in its level.
+ * @param path                  The serials of the moves after the node, path[depth] onwards.
  */
-void queue_push_head(Queue* queue, uint32_t state, uint64_t steps, uint8_t steps_size)
+static void bfs_worker_append_paths(BfsWorker* worker, uint8_t depth, uint32_t node, uint8_t* path)
 {
-    queue -> head = node_create(NULL, state, steps, steps_size);
-    queue -> last = queue -> head;
-    queue -> size = 1;
+    const BfsLevel* level = worker -> level;
+    const BfsParents* parents = level -> parents + depth;
+
+    for (uint32_t i = parents -> first[node]; i < parents -> first[node + 1] && !worker -> failed; i++)
+    {
+        path[depth - 1] = parents -> serials[i];
+
+        if (depth > 1)
+        {
+            bfs_worker_append_paths(worker, depth - 1, parents -> parents[i], path);
+            continue;
+        }
+
+        char string[1024];
+
+        bfs_format_path(string, level -> all_moves, path, level -> depth);
+        bfs_worker_append(worker, string);
+    }
 }
 
 /**
- *                       Adds a new node to the end of the queue.
+ *                       Records a solution in the buffer of a worker.
  *
- * This function creates a new node with the given state, steps, and steps_size,
- * and appends it to the end of the queue. The queue size is incremented by 1.
+ * This function walks the parents of the node back to the first level to rebuild the
+ * moves of the path.
  *
- * @param queue                 The queue to which the new node is added.
- * @param state                 The state of the new node.
- * @param steps                 The number of steps of the new node.
- * @param steps_size            The number of steps size of the new node.
+ * @param worker                The worker.
+ * @param index                 The index of the solved node in its level.
  */
-void queue_push(Queue* queue, uint32_t state, uint64_t steps, uint8_t steps_size)
+static void bfs_worker_report(BfsWorker* worker, uint64_t index)
 {
-    queue -> last = node_create(queue -> last, state, steps, steps_size);
+    const BfsLevel* level = worker -> level;
+    uint8_t path[BFS_MAX_DEPTH];
+
+    if (level -> all)
+    {
+        bfs_worker_append_paths(worker, level -> depth, index, path);
+        return;
+    }
+
+    for (uint8_t depth = level -> depth; depth > 0; depth--)
+    {
+        const BfsFrontier* part = level -> levels[depth];
+
+        // the level is made of the parts output by the workers, in worker order
+        while (index >= part -> size)
+            index -= part++ -> size;
+
+        path[depth - 1] = part -> moves[index];
+        index = part -> parents[index];
+    }
 
-    queue -> size++;
+    char string[1024];
+
+    bfs_format_path(string, level -> all_moves, path, level -> depth);
+    bfs_worker_append(worker, string);
 }
 
 /**
- *                       Removes and returns the node at the head of the queue.
+ *                       Expands one node of the frontier.
  *
- * This function decreases the queue size by one, updates the head to the next node,
- * and returns the original head node. It assumes that the queue is not empty when called.
+ * @param worker                The worker.
+ * @param part                  The part of the frontier holding the node.
+ * @param i                     The index of the node in the part.
+ * @param node                  The index of the node in the level.
+ */
+static void bfs_worker_expand_node(BfsWorker* worker, const BfsFrontier* part, size_t i, uint32_t node)
+{
+    const BfsLevel* level = worker -> level;
+    const uint32_t state = part -> states[i];
+    const uint8_t phase = part -> phases[i];
+
+    if (is_original_state(bfs_packed_state(level, state), level -> original_states))
+    {
+        // with constraints, only the accepting states of the automaton end a solution
+        if ((level -> edges_all0 || edge_phase_solved(phase)) &&
+            (level -> automaton == NULL || level -> automaton -> accepting == NULL || level -> automaton -> accepting[part -> contexts[i]]))
+            bfs_worker_report(worker, node);
+
+        return;
+    }
+
+    if (level -> depth >= level -> max_depth)
+        return;
+
+    const uint8_t last_step = part -> moves[i];
+
+    if (level -> kernel != NULL)
+    {
+        uint32_t new_states[18];
+        uint8_t new_phases[18];
+        uint8_t serials[18];
+        const uint8_t size = level -> kernel -> expand(state, phase, last_step, new_states, new_phases, serials);
+
+        for (uint8_t j = 0; j < size; j++)
+            bfs_worker_push(worker, new_states[j], new_phases[j], node, serials[j], BFS_NO_CONTEXT);
+
+        return;
+    }
+
+    if (level -> automaton != NULL)
+    {
+        const MoveAutomaton* automaton = level -> automaton;
+        const uint32_t context = part -> contexts[i];
+
+        for (uint32_t t = automaton -> first[context]; t < automaton -> first[context + 1]; t++)
+        {
+            const uint8_t serial = automaton -> serials[t];
+            const uint32_t new_state = level -> table != NULL ? move_table_next(level -> table, state, serial) :
+                                                                automaton -> moves[serial].transform(state);
+
+            bfs_worker_push(worker, new_state, EDGE_PHASE_TABLE[serial][phase], node, serial, automaton -> targets[t]);
+        }
+
+        return;
+    }
+
+    for (uint8_t index = 1; index < 19; index++)
+    {
+        const Move m = level -> moves_map_2d[last_step][index];
+
+        if (m.transform == NULL || m.serial == -1)
+            break;
+
+        const uint32_t new_state = level -> table != NULL ? move_table_next(level -> table, state, m.serial) : m.transform(state);
+
+        bfs_worker_push(worker, new_state, EDGE_PHASE_TABLE[m.serial][phase], node, m.serial, BFS_NO_CONTEXT);
+    }
+}
+
+/**
+ *                       Expands a block of frontier nodes with the batch move kernels.
  *
- * @param queue                 The queue from which to pop the head node.
+ * This function checks all the nodes of the block against the original states at once,
+ * groups the others by their last move and applies every allowed next move to a whole
+ * group with one batch kernel call.
  *
- * @return                      The node removed from the head of the queue.
+ * @param worker                The worker.
+ * @param part                  The part of the frontier holding the block.
+ * @param begin                 The index of the first node of the block in the part.
+ * @param size                  How many nodes, at most BFS_BLOCK_SIZE.
+ * @param node                  The index of the first node of the block in the level.
  */
+static void bfs_worker_expand_block(BfsWorker* worker, const BfsFrontier* part, size_t begin, size_t size, uint32_t node)
+{
+    const BfsLevel* level = worker -> level;
+    const uint32_t* states = part -> states + begin;
+    bool hits[BFS_BLOCK_SIZE];
+
+    is_original_state_x8(states, size, level -> original_states, hits);
+
+    // counting sort of the nodes to expand by their last move
+    uint32_t sorted_states[BFS_BLOCK_SIZE];
+    uint32_t sorted_nodes[BFS_BLOCK_SIZE];
+    uint8_t sorted_phases[BFS_BLOCK_SIZE];
+    uint16_t offsets[20] = {0};
+
+    for (size_t i = 0; i < size; i++)
+    {
+        if (hits[i])
+        {
+            if (level -> edges_all0 || edge_phase_solved(part -> phases[begin + i]))
+                bfs_worker_report(worker, node + i);
+        }
+        else if (level -> depth < level -> max_depth)
+            offsets[part -> moves[begin + i] + 1]++;
+    }
+
+    for (uint8_t i = 1; i < 20; i++)
+        offsets[i] += offsets[i - 1];
+
+    uint16_t cursor[19];
+
+    for (uint8_t i = 0; i < 19; i++)
+        cursor[i] = offsets[i];
+
+    for (size_t i = 0; i < size; i++)
+    {
+        if (!hits[i] && level -> depth < level -> max_depth)
+        {
+            const uint8_t last_step = part -> moves[begin + i];
 
-Node* queue_pop(Queue* queue)
+            sorted_states[cursor[last_step]] = states[i];
+            sorted_phases[cursor[last_step]] = part -> phases[begin + i];
+            sorted_nodes[cursor[last_step]++] = node + i;
+        }
+    }
+
+    uint32_t new_states[BFS_BLOCK_SIZE];
+
+    for (uint8_t last_step = 0; last_step < 19; last_step++)
+    {
+        const uint16_t start = offsets[last_step];
+        const uint16_t count = offsets[last_step + 1] - start;
+
+        if (count == 0)
+            continue;
+
+        for (uint8_t index = 1; index < 19; index++)
+        {
+            const Move m = level -> moves_map_2d[last_step][index];
+
+            if (m.transform == NULL || m.serial == -1)
+                break;
+
+            const uint8_t* phase_table = EDGE_PHASE_TABLE[m.serial];
+
+            move_dispatch_batch(m.serial)(sorted_states + start, new_states, count);
+
+            for (uint16_t i = 0; i < count; i++)
+                bfs_worker_push(worker, new_states[i], phase_table[sorted_phases[start + i]], sorted_nodes[start + i], m.serial,
+                                BFS_NO_CONTEXT);
+        }
+    }
+}
+
+/**
+ *                       Expands the share of the frontier of a worker.
+ *
+ * The frontier is made of the parts output by the workers of the previous level, in
+ * worker order. The share of a worker is a range of the whole frontier, it may span
+ * several parts.
+ *
+ * @param argument              The worker.
+ *
+ * @return                      NULL.
+ */
+static void* bfs_worker_run(void* argument)
 {
-    queue -> size--;
-    Node* result = queue -> head;
-    queue -> head = queue -> head -> next;
+    BfsWorker* worker = (BfsWorker*)(argument);
+    const BfsLevel* level = worker -> level;
+    uint64_t offset = 0;
+
+    for (uint16_t p = 0; p < level -> levels_size[level -> depth] && offset < worker -> end; p++)
+    {
+        const BfsFrontier* part = level -> levels[level -> depth] + p;
+        const uint64_t begin = worker -> begin > offset ? worker -> begin - offset : 0;
+        const uint64_t end = worker -> end < offset + part -> size ? worker -> end - offset : part -> size;
+
+        for (uint64_t i = begin; i < end && !worker -> failed;)
+        {
+            if (level -> simd)
+            {
+                const size_t size = end - i < BFS_BLOCK_SIZE ? end - i : BFS_BLOCK_SIZE;
 
-    return result;
+                bfs_worker_expand_block(worker, part, i, size, offset + i);
+                i += size;
+            }
+            else
+            {
+                bfs_worker_expand_node(worker, part, i, offset + i);
+                i++;
+            }
+        }
+
+        offset += part -> size;
+    }
+
+    return NULL;
 }
 
+typedef struct bfs_arrival
+{
+    uint64_t key; // the key of the node reached, see bfs_key
+    uint32_t index; // the index of the path among the paths of the level
+} BfsArrival;
+
 /**
- *                       Initializes and returns an empty queue.
+ *                       Compares two arrivals by key, then by index.
  *
- * This function creates a new Queue instance with size set to 0, and both
- * head and last pointers initialized to NULL, indicating that the queue
- * is empty.
+ * @param a                     The first arrival.
+ * @param b                     The second arrival.
  *
- * @return                      A newly created empty queue.
+ * @return                      Negative, zero or positive, as for qsort.
  */
-Queue queue_create()
+static int bfs_arrival_compare(const void* a, const void* b)
 {
-    Queue queue;
-    queue.size = 0;
-    queue.head = NULL;
-    queue.last = NULL;
+    const BfsArrival* x = (const BfsArrival*)(a);
+    const BfsArrival* y = (const BfsArrival*)(b);
 
-    return queue;
+    if (x -> key != y -> key)
+        return x -> key < y -> key ? -1 : 1;
+
+    return x -> index < y -> index ? -1 : x -> index > y -> index;
 }
 
 /**
- *                       Prints the steps required to solve a cube.
+ *                       Merges the paths reaching the same node of a level.
  *
- * This function takes a sequence of moves represented as a bit packed
- * integer, and prints out the corresponding move sequence as a string.
+ * The paths output by the workers are sorted by the key of their node. Every run of the
+ * same key becomes one node, and the parent and the last move of every path of the run
+ * are recorded in level -> parents, so all of them can be printed if the node is solved.
+ * The nodes are then marked as visited, for the next levels only.
  *
- * @param map                   An array of moves to use for looking up move names.
- * @param steps                 The sequence of moves to print, bit packed into a uint64_t.
- * @param size                  The number of moves in the sequence.
- * @param moves_bits            The number of bits required to represent a move, (if there are 3 moves available, moves_bits = 2; if there are 8 moves available, moves_bits = 3).
- * @param moves_musk            A mask value to use when unpacking the moves from the steps, (if moves_bits = 3 => moves_musk = 111b).
+ * @param level                 The search, level -> depth is the depth of the paths.
+ * @param parts                 The paths as output by the workers, replaced by the nodes in parts[0].
+ * @param parts_size            How many parts, set to 1.
+ *
+ * @return                      False if out of memory.
  */
-void bfs_print_step(const Move* map, uint64_t steps, uint8_t size, uint8_t moves_bits, uint8_t moves_musk)
+static bool bfs_merge(BfsLevel* level, BfsFrontier* parts, uint16_t* parts_size)
 {
-    char string[128] = "steps: \0";
+    BfsParents* parents = level -> parents + level -> depth;
+    BfsFrontier paths = {0};
+    BfsFrontier nodes = {0};
+    size_t size = 0;
+    size_t nodes_size = 0;
 
-    for (uint8_t i = 0; i < size; i++)
+    for (uint16_t p = 0; p < *parts_size; p++)
+        size += parts[p].size;
+
+    paths.states = (uint32_t*)(malloc(size * sizeof(uint32_t) + 1));
+    paths.phases = (uint8_t*)(malloc(size * sizeof(uint8_t) + 1));
+    paths.parents = (uint32_t*)(malloc(size * sizeof(uint32_t) + 1));
+    paths.moves = (uint8_t*)(malloc(size * sizeof(uint8_t) + 1));
+
+    BfsArrival* arrivals = (BfsArrival*)(malloc(size * sizeof(BfsArrival) + 1));
+
+    for (uint16_t p = 0; p < *parts_size && paths.states != NULL && paths.phases != NULL && paths.parents != NULL && paths.moves != NULL; p++)
     {
-        uint8_t a = steps >> (moves_bits * (size - 1 - i)) & moves_musk; // unpack single move
-        strcat(string, map[a].symbol);
-        strcat(string, "\t");
+        memcpy(paths.states + paths.size, parts[p].states, parts[p].size * sizeof(uint32_t));
+        memcpy(paths.phases + paths.size, parts[p].phases, parts[p].size * sizeof(uint8_t));
+        memcpy(paths.parents + paths.size, parts[p].parents, parts[p].size * sizeof(uint32_t));
+        memcpy(paths.moves + paths.size, parts[p].moves, parts[p].size * sizeof(uint8_t));
+        paths.size += parts[p].size;
+    }
+
+    for (uint16_t p = 0; p < *parts_size; p++)
+        bfs_frontier_free(parts + p);
+
+    *parts_size = 1;
+
+    if (paths.size != size || arrivals == NULL)
+    {
+        bfs_frontier_free(&paths);
+        free(arrivals);
+        return false;
+    }
+
+    for (size_t i = 0; i < size; i++)
+        arrivals[i] = (BfsArrival){bfs_key(level, paths.states[i], paths.phases[i], paths.moves[i]), i};
+
+    qsort(arrivals, size, sizeof(BfsArrival), bfs_arrival_compare);
+
+    for (size_t i = 0; i < size; i++)
+        nodes_size += i == 0 || arrivals[i].key != arrivals[i - 1].key;
+
+    parents -> first = (uint32_t*)(malloc((nodes_size + 1) * sizeof(uint32_t)));
+    parents -> parents = (uint32_t*)(malloc(size * sizeof(uint32_t) + 1));
+    parents -> serials = (uint8_t*)(malloc(size * sizeof(uint8_t) + 1));
+    nodes.states = (uint32_t*)(malloc(nodes_size * sizeof(uint32_t) + 1));
+    nodes.phases = (uint8_t*)(malloc(nodes_size * sizeof(uint8_t) + 1));
+    nodes.moves = (uint8_t*)(malloc(nodes_size * sizeof(uint8_t) + 1));
+
+    if (parents -> first == NULL || parents -> parents == NULL || parents -> serials == NULL ||
+        nodes.states == NULL || nodes.phases == NULL || nodes.moves == NULL)
+    {
+        bfs_frontier_free(&paths);
+        bfs_frontier_free(&nodes);
+        free(arrivals);
+        return false;
+    }
+
+    for (size_t i = 0; i < size; i++)
+    {
+        const uint64_t key = arrivals[i].key;
+        const uint32_t path = arrivals[i].index;
+
+        // the node keeps the last move of its first path, the others have the same next moves
+        if (i == 0 || key != arrivals[i - 1].key)
+        {
+            parents -> first[nodes.size] = i;
+            nodes.states[nodes.size] = paths.states[path];
+            nodes.phases[nodes.size] = paths.phases[path];
+            nodes.moves[nodes.size++] = paths.moves[path];
+            level -> visited[key / 64] |= 1ull << (key & 63);
+        }
+
+        parents -> parents[i] = paths.parents[path];
+        parents -> serials[i] = paths.moves[path];
     }
-    
-    puts(string);
+
+    parents -> first[nodes.size] = size;
+    parents -> size = nodes.size;
+    nodes.capacity = nodes.size;
+    parts[0] = nodes;
+
+    bfs_frontier_free(&paths);
+    free(arrivals);
+
+    return true;
 }
 
 /**
- *                       Checks edge phases is correct.
+ *                       Searches the levels one after the other, each split between threads.
+ *
+ * Every level is a frontier of nodes cut into one contiguous share per thread. The workers
+ * write the nodes of the next level and the solutions they find into buffers of their
+ * own, so they never wait on each other; joining them is the barrier between two levels.
+ * The buffers are then taken in worker order, the solutions come out in the same order
+ * as a single thread would print them, unless with BFS_DEDUP_FIRST: the thread that sets
+ * the visited bit of a node first keeps its path, so the solutions depend on the timing.
+ * With BFS_DEDUP_ALL, the paths reaching the same node are merged before every level is
+ * expanded, which keeps the order.
  *
- * This function takes an initial edge phase, a sequence of moves, and the size
- * of the sequence, and checks if the final edge phase of the sequence of moves
- * is one of the edge phases. If the final edge phase of the sequence of moves is
- * one of the edge phases, the function returns true; otherwise, it returns false.
+ * Once a level is expanded, only the parent and the last move of its nodes are kept, the
+ * solutions are rebuilt from them.
  *
- * @param phase                 The initial edge phase.
- * @param steps                 A sequence of moves to check.
- * @param steps_size            The size of the sequence of moves.
- * @param moves_bits            The number of bits needed to represent a single move.
- * @param moves_musk            A mask of all possible moves.
+ * @param level                 The search, with the moves and the states to check.
+ * @param first                 The frontier of the paths of 1 move.
+ * @param threads               How many threads expand every level.
  *
- * @return                      True if the final edge phase is one of the edge phases, false otherwise.
+ * @return                      How many solutions were printed.
  */
-bool bfs_check_edge_phase(uint8_t phase, uint64_t steps, uint8_t steps_size, uint8_t moves_bits, uint8_t moves_musk)
+static uint32_t bfs_level_search(BfsLevel* level, BfsFrontier first, uint16_t threads)
 {
-    for (uint8_t i = 0; i < steps_size; i++)
+    BfsWorker* workers = (BfsWorker*)(calloc(threads, sizeof(BfsWorker)));
+    pthread_t* ids = (pthread_t*)(malloc(threads * sizeof(pthread_t)));
+    uint32_t solution_count = 0;
+
+    level -> levels = (BfsFrontier**)(calloc(level -> max_depth + 2, sizeof(BfsFrontier*)));
+    level -> levels_size = (uint16_t*)(calloc(level -> max_depth + 2, sizeof(uint16_t)));
+
+    if (workers == NULL || ids == NULL || level -> levels == NULL || level -> levels_size == NULL ||
+        (level -> levels[1] = (BfsFrontier*)(malloc(sizeof(BfsFrontier)))) == NULL)
     {
-        uint8_t a = steps >> (moves_bits * (steps_size - 1 - i)) & moves_musk;
+        printf("BFS out of memory at level 1\n");
+        free(workers);
+        free(ids);
+        free(level -> levels);
+        free(level -> levels_size);
+        bfs_frontier_free(&first);
+        return 0;
+    }
+
+    level -> levels[1][0] = first;
+    level -> levels_size[1] = 1;
 
-        switch (a)
+    for (level -> depth = 1; level -> depth <= level -> max_depth; level -> depth++)
+    {
+        BfsFrontier* parts = level -> levels[level -> depth];
+        uint64_t size = 0;
+
+        if (level -> all && !bfs_merge(level, parts, level -> levels_size + level -> depth))
+        {
+            printf("BFS out of memory at level %d\n", level -> depth);
+            break;
+        }
+
+        for (uint16_t p = 0; p < level -> levels_size[level -> depth]; p++)
+            size += parts[p].size;
+
+        if (size == 0)
+            break;
+
+        // the nodes of the next level point to their parent with 32 bits
+        if (size > UINT32_MAX)
+        {
+            printf("BFS level %d too large: %" PRIu64 " nodes\n", level -> depth, size);
+            break;
+        }
+
+        printf("searching level: %d, frontier size: %" PRIu64 "\n", level -> depth, size);
+
+        // small frontiers are not worth a thread
+        const uint16_t used = size / BFS_THREAD_NODES + 1 < threads ? size / BFS_THREAD_NODES + 1 : threads;
+        bool failed = false;
+        uint16_t started = 0;
+
+        for (uint16_t i = 0; i < used; i++)
+            workers[i] = (BfsWorker){level, size * i / used, size * (i + 1) / used};
+
+        while (started + 1 < used && pthread_create(ids + started, NULL, bfs_worker_run, workers + started) == 0)
+            started++;
+
+        // the calling thread is the last worker, and every worker no thread could be started for
+        for (uint16_t i = started; i < used; i++)
+            bfs_worker_run(workers + i);
+
+        for (uint16_t i = 0; i < used; i++)
+        {
+            if (i < started)
+                pthread_join(ids[i], NULL);
+
+            if (workers[i].text_size > 0)
+                fwrite(workers[i].text, 1, workers[i].text_size, stdout);
+
+            free(workers[i].text);
+            solution_count += workers[i].solution_count;
+            failed |= workers[i].failed;
+        }
+
+        // the merged nodes keep their paths in level -> parents
+        for (uint16_t p = 0; p < level -> levels_size[level -> depth]; p++)
+        {
+            if (level -> all)
+                bfs_frontier_free(parts + p);
+            else
+                bfs_frontier_shrink(parts + p);
+        }
+
+        if (level -> depth == level -> max_depth)
+            break;
+
+        // the parts output by the workers are the next level
+        BfsFrontier* next = (BfsFrontier*)(malloc(used * sizeof(BfsFrontier)));
+
+        if (next != NULL)
+        {
+            for (uint16_t i = 0; i < used; i++)
+                next[i] = workers[i].next;
+
+            level -> levels[level -> depth + 1] = next;
+            level -> levels_size[level -> depth + 1] = used;
+        }
+        else
         {
-            case 0: {phase = edge_R_transform(phase); break;}
-            case 1: {phase = edge_L_transform(phase); break;}
-            case 2: {phase = edge_F_transform(phase); break;}
-            case 3: {phase = edge_B_transform(phase); break;}
-            case 4:
-            case 5:
-            case 6: break;
-            case 7: {phase = edge_E_transform(phase); break;}
-            case 8: {phase = edge_EPrime_transform(phase); break;}
-            case 9: {phase = edge_E2_transform(phase); break;}
-            case 10:
-            case 11:
-            case 12: break;
-            case 13: {phase = edge_E_transform(phase); break;}
-            case 14: {phase = edge_EPrime_transform(phase); break;}
-            case 15: {phase = edge_E2_transform(phase); break;}
-            case 16: {phase = edge_EPrime_transform(phase); break;}
-            case 17: {phase = edge_E_transform(phase); break;}
-            case 18: {phase = edge_E2_transform(phase); break;}
-            default: break;
+            for (uint16_t i = 0; i < used; i++)
+                bfs_frontier_free(&workers[i].next);
+        }
+
+        if (failed || next == NULL)
+        {
+            printf("BFS out of memory at level %d\n", level -> depth + 1);
+            break;
         }
     }
 
-    return phase == 3 ||
-            phase == edge_E_transform(3) ||
-            phase == edge_EPrime_transform(3) ||
-            phase == edge_E2_transform(3);
+    for (uint8_t depth = 1; depth <= level -> max_depth + 1; depth++)
+    {
+        for (uint16_t p = 0; p < level -> levels_size[depth]; p++)
+            bfs_frontier_free(level -> levels[depth] + p);
+
+        free(level -> levels[depth]);
+    }
+
+    free(level -> levels);
+    free(level -> levels_size);
+    free(workers);
+    free(ids);
+
+    return solution_count;
 }
 
 /**
@@ -215,6 +836,12 @@ bool bfs_check_edge_phase(uint8_t phase, uint64_t steps, uint8_t steps_size, uin
  * and solves a cube using BFS algorithm. If the cube is solvable, the function prints out the solution and returns true;
  * otherwise, the function returns false.
  *
+ * The levels are searched one after the other, each stored as contiguous arrays: every level
+ * is split between the threads, which write the next level into buffers of their own, and
+ * a state already queued is skipped by looking it up in a lock-free bitmap of the ranked states.
+ * BFS_DEDUP_FIRST keeps the first path found to every state, BFS_DEDUP_ALL keeps every
+ * shortest path to it as a parent of one node, so all the optimal solutions are printed.
+ *
  * @param moves                 An array of moves to use for solving the cube.
  * @param moves_map             A 2D array of moves to use for solving the cube.
  * @param original_states       An array of original states to check against.
@@ -222,99 +849,132 @@ bool bfs_check_edge_phase(uint8_t phase, uint64_t steps, uint8_t steps_size, uin
  * @param edges_phase_state     The initial edge phase of the cube.
  * @param min_depth             The minimum depth of the solution.
  * @param max_depth             The maximum depth of the solution.
+ * @param table                 The transition table to walk instead of the move functions, or NULL.
+ *                               When given, the nodes hold dense indices instead of packed states.
+ * @param simd                  Expands the frontier block by block with the batch move kernels (ignored with a table).
+ * @param kernel                The generated kernel of moves_map, or NULL (ignored with a table, simd or an automaton).
+ * @param automaton             The pruning automaton to step instead of moves_map, or NULL (ignored with dedup).
+ * @param threads               How many threads expand every level, 0 for one per CPU.
+ * @param dedup                 BFS_DEDUP_NONE, BFS_DEDUP_FIRST or BFS_DEDUP_ALL.
  */
 void cube_bfs_solver(const Move* moves, const Move* moves_map, const int* original_states,
-                uint32_t state, uint8_t edges_phase_state, uint8_t min_depth, uint8_t max_depth)
+                uint32_t state, uint8_t edges_phase_state, uint8_t min_depth, uint8_t max_depth,
+                const MoveTable* table, bool simd, const SearchKernel* kernel, const MoveAutomaton* automaton,
+                uint16_t threads, uint8_t dedup)
 {
     // there are 19 possible moves in 223 cube
     const uint8_t moves_size = 19;
     const Move ALL_MOVES[19] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2}; //all possible moves
     Move moves_map_2d[19][19] = {};
 
-    uint8_t first_valid_index = 0;
-
     // convert moves_map to 2d array
     for (uint8_t i = 0; i < moves_size; i++)
     {
-        if (moves[i].transform != NULL && moves[i].serial > first_valid_index)
-            first_valid_index = moves[i].serial;
-
         for (uint8_t j = 0; j < moves_size; j++)
             moves_map_2d[i][j] = moves_map[i * moves_size + j];
     }
 
     // represent edges is zero or not. if is zero then we not consider the edge in solution. if is not zero then we consider the edge
     const bool edges_all0 = (state & 0xff) == 0;
-    const uint8_t moves_bits = first_valid_index == 0 ? 1 : log2(first_valid_index) + 1; // how many bits are needed to represent all moves
-    const uint8_t moves_mask = (1 << moves_bits) - 1; // musk of moves bits
 
-    uint8_t level = 0; //current step
-    uint16_t solution_count = 0;
     uint64_t current_time = get_current_time(); // start time
-    Queue queue = queue_create();
+    // the nodes of a deduplicated search only differ by their last move, an automaton state would split them
+    if (dedup != BFS_DEDUP_NONE)
+        automaton = NULL;
 
-    // 
-    for (uint8_t i = 0; i < moves_size; i++)
-    {
-        const Move second_move = moves_map_2d[i][1];
+    BfsLevel level = {moves_map_2d, original_states, table, ALL_MOVES, edges_all0, simd && table == NULL && automaton == NULL,
+                      table == NULL && !simd && automaton == NULL ? kernel : NULL, automaton, 0, max_depth};
+    BfsFrontier first = {0};
 
-        if (second_move.transform != NULL)
-        {
-            Move m = moves[i];
-            if (i == 0) queue_push_head(&queue, m.transform(state), m.serial, 1);
-            else queue_push(&queue, m.transform(state), m.serial, 1);
-        }
-    }
+    // every state is replaced by its dense index when walking the transition table
+    if (table != NULL)
+        state = move_table_index(table, state);
+
+    edge_phase_table_init();
 
+    if (threads == 0)
+        threads = sysconf(_SC_NPROCESSORS_ONLN) > 0 ? sysconf(_SC_NPROCESSORS_ONLN) : 1;
 
-    while (queue.size > 0)
+    level.ranks = edges_all0 ? CUBE_CORNERS_SIZE : CUBE_PHASE_STATES_SIZE;
+
+    // moves with the same next moves lead to the same searches, they share a class
+    uint32_t successors[19] = {0};
+
+    for (uint8_t i = 0; i < moves_size; i++)
     {
-        Node* node = queue_pop(&queue);
+        for (uint8_t j = 1; j < moves_size && moves_map_2d[i][j].transform != NULL; j++)
+            successors[i] |= 1u << moves_map_2d[i][j].serial;
 
-        const uint32_t current_state = node -> state;
-        const uint64_t current_steps = node -> steps;
-        const uint8_t current_steps_size = node -> steps_size;
-        const uint8_t last_step = current_steps & moves_mask;
+        level.class_of[i] = level.classes;
 
-        if (is_original_state(current_state, original_states))
+        for (uint8_t j = 0; j < i; j++)
         {
-            if (edges_all0 || bfs_check_edge_phase(edges_phase_state, current_steps, current_steps_size, moves_bits, moves_mask))
+            if (successors[j] == successors[i])
             {
-                solution_count++;
-                bfs_print_step(ALL_MOVES, current_steps, current_steps_size, moves_bits, moves_mask);
+                level.class_of[i] = level.class_of[j];
+                break;
             }
-    
-            free(node);
-            continue;
         }
 
-        if (current_steps_size > level)
-        {
-            level++;
-            printf("searching level: %d, current deque size: %lld\n", current_steps_size, queue.size);
-        }
+        if (level.class_of[i] == level.classes)
+            level.classes++;
+    }
 
-        if (current_steps_size < max_depth)
-        {
-            const uint8_t new_steps_size = current_steps_size + 1;
-            uint8_t index = 1;
+    level.all = dedup == BFS_DEDUP_ALL;
 
-            while (true)
-            {
-                Move m = moves_map_2d[last_step][index++];
+    if (level.max_depth >= BFS_MAX_DEPTH)
+        level.max_depth = BFS_MAX_DEPTH - 1;
 
-                if (m.transform == NULL || m.serial == -1)
-                    break;
+    if (dedup != BFS_DEDUP_NONE)
+        level.visited = (uint64_t*)(calloc(((uint64_t)(level.ranks) * level.classes + 63) / 64, sizeof(uint64_t)));
 
-                const uint32_t new_state = m.transform(current_state);
-                const uint64_t new_steps = current_steps << moves_bits | m.serial;
+    if (level.all)
+        level.parents = (BfsParents*)(calloc(level.max_depth + 1, sizeof(BfsParents)));
 
-                queue_push(&queue, new_state, new_steps, new_steps_size);
-            }
+    if ((dedup != BFS_DEDUP_NONE && level.visited == NULL) || (level.all && level.parents == NULL))
+    {
+        printf("BFS out of memory: visited states\n");
+        free(level.visited);
+        return;
+    }
+
+    // the first moves are the transitions of the start state when walking an automaton
+    const uint32_t first_begin = automaton != NULL ? automaton -> first[AUTOMATON_START] : 0;
+    const uint32_t first_end = automaton != NULL ? automaton -> first[AUTOMATON_START + 1] : moves_size;
+
+    for (uint32_t t = first_begin; t < first_end; t++)
+    {
+        const uint8_t i = automaton != NULL ? automaton -> serials[t] : t;
+
+        if (automaton == NULL && moves_map_2d[i][1].transform == NULL)
+            continue;
+
+        const uint32_t new_state = table != NULL ? move_table_next(table, state, i) : moves[i].transform(state);
+        const uint8_t new_phase = EDGE_PHASE_TABLE[i][edges_phase_state];
+
+        if (dedup != BFS_DEDUP_NONE && !bfs_visit(&level, new_state, new_phase, i))
+            continue;
+
+        if (!bfs_frontier_push(&first, new_state, new_phase, 0, i, automaton != NULL ? automaton -> targets[t] : BFS_NO_CONTEXT))
+        {
+            printf("BFS out of memory at level 1\n");
+            bfs_frontier_free(&first);
+            free(level.visited);
+            free(level.parents);
+            return;
         }
+    }
+
+    const uint32_t solution_count = bfs_level_search(&level, first, threads);
 
-        free(node);    
+    for (uint8_t i = 0; level.parents != NULL && i <= level.max_depth; i++)
+    {
+        free(level.parents[i].first);
+        free(level.parents[i].parents);
+        free(level.parents[i].serials);
     }
 
+    free(level.visited);
+    free(level.parents);
     printf("search end in %lf (s), find total %d solutions: ", (get_current_time() - current_time) / 1000.0, solution_count);
-}
\ No newline at end of file
+}
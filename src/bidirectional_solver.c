@@ -0,0 +1,391 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bidirectional_solver.h"
+#include "cube_rank.h"
+#include "goal_cache.h"
+
+#define BIDIRECTIONAL_START 19 // the last move of the empty forward path
+
+typedef struct bidirectional_search
+{
+    const Move* moves_map;
+    const int* original_states;
+    bool edges_all0;
+    uint8_t min_depth;
+    uint32_t state; // the initial state of the cube
+    uint8_t phase; // the initial edge phase of the cube
+    uint32_t successors[BIDIRECTIONAL_START + 1]; // bit m is set if move m may follow the move (or the start)
+    uint32_t used; // bit m is set if move m appears anywhere in moves_map
+    uint8_t inverse[19]; // the move undoing every move
+    uint8_t flips[19]; // 1 if the move changes the edge flip, 0 for all if the edges are ignored
+    uint32_t solution_count;
+} BidirectionalSearch;
+
+/**
+ *                       Appends a node to a level, growing it if it is full.
+ *
+ * @param level                 The level to append to.
+ * @param key                   The packed state and the edge flip.
+ * @param steps                 The moves of the path.
+ * @param move                  The last (forward) or first (backward) move of the path.
+ *
+ * @return                      True if the node is appended, false if out of memory.
+ */
+static bool bidirectional_push(BidirectionalLevel* level, uint64_t key, uint64_t steps, uint8_t move)
+{
+    if (level -> size == level -> capacity)
+    {
+        const size_t capacity = level -> capacity == 0 ? 1024 : 2 * level -> capacity;
+        BidirectionalNode* nodes = (BidirectionalNode*)(realloc(level -> nodes, capacity * sizeof(BidirectionalNode)));
+
+        if (nodes == NULL)
+            return false;
+
+        level -> nodes = nodes;
+        level -> capacity = capacity;
+    }
+
+    level -> nodes[level -> size++] = (BidirectionalNode){key, steps, move};
+    return true;
+}
+
+/**
+ *                       Orders two nodes by state, then by path.
+ *
+ * @param a                     The first BidirectionalNode.
+ * @param b                     The second BidirectionalNode.
+ *
+ * @return                      Negative, zero or positive, as qsort expects.
+ */
+static int bidirectional_compare(const void* a, const void* b)
+{
+    const BidirectionalNode* x = (const BidirectionalNode*)(a);
+    const BidirectionalNode* y = (const BidirectionalNode*)(b);
+
+    if (x -> key != y -> key)
+        return x -> key < y -> key ? -1 : 1;
+
+    return x -> steps < y -> steps ? -1 : x -> steps > y -> steps;
+}
+
+/**
+ *                       Checks if a packed state and an edge flip are solved.
+ *
+ * @param search                The search.
+ * @param key                   The packed state and the edge flip, state << 1 | flip.
+ *
+ * @return                      True if the state is an original state with its edges solved.
+ */
+static bool bidirectional_solved(const BidirectionalSearch* search, uint64_t key)
+{
+    const uint32_t state = key >> 1;
+
+    return is_original_state(state, search -> original_states) &&
+           (search -> edges_all0 || edge_phase_solved(edges_phase(state, key & 1)));
+}
+
+/**
+ *                       Expands every forward path by one move.
+ *
+ * Paths that already solve the cube with at least min_depth moves are not extended, like
+ * the BFS and DFS never go through a solution.
+ *
+ * @param search                The search.
+ * @param from                  The paths of depth moves.
+ * @param to                    Where to append the paths of depth + 1 moves.
+ * @param depth                 The length of the paths in from.
+ *
+ * @return                      True if the level is expanded, false if out of memory.
+ */
+static bool bidirectional_forward(const BidirectionalSearch* search, const BidirectionalLevel* from,
+                                  BidirectionalLevel* to, uint8_t depth)
+{
+    const Move ALL_MOVES[19] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2};
+
+    for (size_t i = 0; i < from -> size; i++)
+    {
+        const BidirectionalNode node = from -> nodes[i];
+        const uint32_t state = node.key >> 1;
+
+        if (depth > 0 && depth >= search -> min_depth && bidirectional_solved(search, node.key))
+            continue;
+
+        for (uint8_t m = 0; m < 19; m++)
+        {
+            if (!(search -> successors[node.move] >> m & 1))
+                continue;
+
+            const uint64_t key = (uint64_t)(ALL_MOVES[m].transform(state)) << 1 | ((node.key & 1) ^ search -> flips[m]);
+
+            if (!bidirectional_push(to, key, node.steps | (uint64_t)(m) << (5 * depth), m))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ *                       Expands every backward path by one move, played before the others.
+ *
+ * @param search                The search.
+ * @param from                  The paths of depth moves to an original state.
+ * @param to                    Where to append the paths of depth + 1 moves.
+ *
+ * @return                      True if the level is expanded, false if out of memory.
+ */
+static bool bidirectional_backward(const BidirectionalSearch* search, const BidirectionalLevel* from, BidirectionalLevel* to)
+{
+    const Move ALL_MOVES[19] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2};
+
+    for (size_t i = 0; i < from -> size; i++)
+    {
+        const BidirectionalNode node = from -> nodes[i];
+        const uint32_t state = node.key >> 1;
+
+        for (uint8_t m = 0; m < 19; m++)
+        {
+            // the first move of the path must be allowed after m
+            if (!(search -> used >> m & 1) ||
+                (node.move != BIDIRECTIONAL_NONE && !(search -> successors[m] >> node.move & 1)))
+                continue;
+
+            const uint64_t key = (uint64_t)(ALL_MOVES[search -> inverse[m]].transform(state)) << 1 |
+                                 ((node.key & 1) ^ search -> flips[m]);
+
+            if (!bidirectional_push(to, key, node.steps << 5 | m, m))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ *                       Prints a joined path if no shorter prefix solves the cube.
+ *
+ * @param search                The search.
+ * @param steps                 The moves of the path.
+ * @param length                How many moves.
+ */
+static void bidirectional_print(BidirectionalSearch* search, uint64_t steps, uint8_t length)
+{
+    const Move ALL_MOVES[19] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2};
+    char string[1024] = "steps: \0";
+    uint32_t state = search -> state;
+    uint8_t phase = search -> phase;
+
+    for (uint8_t i = 0; i < length; i++)
+    {
+        const uint8_t serial = steps >> (5 * i) & 0x1f;
+
+        // the backward half may go through an original state
+        if (i > 0 && i >= search -> min_depth && is_original_state(state, search -> original_states) &&
+            (search -> edges_all0 || edge_phase_solved(phase)))
+            return;
+
+        state = ALL_MOVES[serial].transform(state);
+        phase = EDGE_PHASE_TABLE[serial][phase];
+        strcat(string, ALL_MOVES[serial].symbol);
+        strcat(string, "\t\0");
+    }
+
+    puts(string);
+    search -> solution_count++;
+}
+
+/**
+ *                       Joins the forward and backward paths meeting on the same cube.
+ *
+ * @param search                The search.
+ * @param forward               The forward paths, sorted by state.
+ * @param backward              The backward paths, sorted by state.
+ * @param forward_depth         The length of the forward paths.
+ * @param backward_depth        The length of the backward paths.
+ */
+static void bidirectional_join(BidirectionalSearch* search, const BidirectionalLevel* forward, const BidirectionalLevel* backward,
+                               uint8_t forward_depth, uint8_t backward_depth)
+{
+    size_t i = 0, j = 0;
+
+    while (i < forward -> size && j < backward -> size)
+    {
+        const uint64_t key = forward -> nodes[i].key;
+
+        if (key < backward -> nodes[j].key)
+        {
+            i++;
+            continue;
+        }
+
+        if (key > backward -> nodes[j].key)
+        {
+            j++;
+            continue;
+        }
+
+        size_t end = j;
+
+        while (end < backward -> size && backward -> nodes[end].key == key)
+            end++;
+
+        for (; i < forward -> size && forward -> nodes[i].key == key; i++)
+        {
+            const BidirectionalNode node = forward -> nodes[i];
+
+            for (size_t k = j; k < end; k++)
+            {
+                const BidirectionalNode other = backward -> nodes[k];
+
+                if (backward_depth > 0 && !(search -> successors[node.move] >> other.move & 1))
+                    continue;
+
+                bidirectional_print(search, node.steps | other.steps << (5 * forward_depth), forward_depth + backward_depth);
+            }
+        }
+
+        j = end;
+    }
+}
+
+/**
+ *                       Solves a cube by searching from both ends.
+ *
+ * This function expands every path from the cube (forward) and every path leading to an
+ * original state (backward, with the moves undone), level by level, and sorts every level
+ * by state. A solution of length d is a forward path of d - k moves and a backward path
+ * of k = min(goal_depth, d) moves that meet on the same cube. The joined paths are printed
+ * if moves_map allows the backward path after the forward one, and no shorter prefix of at
+ * least min_depth moves solves the cube, so the solutions are the same as the BFS and DFS
+ * ones.
+ *
+ * The backward paths do not depend on the cube, so with a goal cache file they are
+ * read from it, or expanded once and written to it for the next queries.
+ *
+ * @param moves_map             A 2D array of moves to use for solving the cube.
+ * @param original_states       An array of original states to check against.
+ * @param state                 The initial state of the cube.
+ * @param edges_phase_state     The initial edge phase of the cube.
+ * @param min_depth             The minimum depth of the solution.
+ * @param max_depth             The maximum depth of the solution, at most BIDIRECTIONAL_MAX_DEPTH.
+ * @param goal_depth            The longest backward paths, at most BIDIRECTIONAL_MAX_DEPTH / 2.
+ * @param goal_cache            The path of the goal cache file, or NULL.
+ */
+void cube_bidirectional_solver(const Move* moves_map, const int* original_states,
+                               uint32_t state, uint8_t edges_phase_state, uint8_t min_depth, uint8_t max_depth,
+                               uint8_t goal_depth, const char* goal_cache)
+{
+    const uint8_t moves_size = 19;
+    const Move ALL_MOVES[19] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2};
+    BidirectionalSearch search = {moves_map, original_states, (state & 0xffu) == 0, min_depth, state, edges_phase_state};
+    BidirectionalLevel forward[BIDIRECTIONAL_MAX_DEPTH / 2 + 1] = {0};
+    BidirectionalLevel backward[BIDIRECTIONAL_MAX_DEPTH / 2 + 1] = {0};
+    uint64_t current_time = get_current_time();
+    bool enough_memory = true;
+
+    puts("start searching");
+    edge_phase_table_init();
+
+    if (goal_depth > BIDIRECTIONAL_MAX_DEPTH / 2)
+        goal_depth = BIDIRECTIONAL_MAX_DEPTH / 2;
+
+    // the forward paths hold at most BIDIRECTIONAL_MAX_DEPTH / 2 moves too
+    if (max_depth > goal_depth + BIDIRECTIONAL_MAX_DEPTH / 2)
+        max_depth = goal_depth + BIDIRECTIONAL_MAX_DEPTH / 2;
+
+    const uint8_t forward_depth = max_depth > goal_depth ? max_depth - goal_depth : 0;
+
+    // the same first moves as the DFS: every move whose row allows a second move
+    for (uint8_t i = 0; i < moves_size; i++)
+    {
+        for (uint8_t j = 1; j < moves_size && moves_map[i * moves_size + j].transform != NULL; j++)
+            search.successors[i] |= 1u << moves_map[i * moves_size + j].serial;
+
+        if (search.successors[i] != 0)
+            search.successors[BIDIRECTIONAL_START] |= 1u << i;
+
+        search.used |= search.successors[i];
+    }
+
+    search.used |= search.successors[BIDIRECTIONAL_START];
+
+    for (uint8_t m = 0; m < moves_size; m++)
+    {
+        const uint32_t moved = ALL_MOVES[m].transform(87652123);
+
+        for (uint8_t n = 0; n < moves_size; n++)
+        {
+            if (ALL_MOVES[n].transform(moved) == 87652123)
+            {
+                search.inverse[m] = n;
+                break;
+            }
+        }
+
+        search.flips[m] = search.edges_all0 ? 0 : edges_flip(moved, EDGE_PHASE_TABLE[m][3]);
+    }
+
+    // depth 0: the cube itself, and every original state with the edge flip of its solved phases
+    const uint8_t flip = search.edges_all0 ? 0 : edges_flip(state, edges_phase_state);
+
+    enough_memory &= bidirectional_push(forward, (uint64_t)(state) << 1 | flip, 0, BIDIRECTIONAL_START);
+
+    for (uint8_t depth = 0; enough_memory && depth < forward_depth; depth++)
+    {
+        enough_memory &= bidirectional_forward(&search, forward + depth, forward + depth + 1, depth);
+        printf("depth %d: %zu forward paths\n", depth + 1, forward[depth + 1].size);
+    }
+
+    for (uint8_t depth = 0; enough_memory && depth <= forward_depth; depth++)
+        qsort(forward[depth].nodes, forward[depth].size, sizeof(BidirectionalNode), bidirectional_compare);
+
+    const uint64_t signature = goal_cache_signature(search.successors, original_states);
+    const bool cached = enough_memory && goal_cache != NULL && goal_cache_load(goal_cache, signature, goal_depth, backward);
+
+    if (!cached)
+    {
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            for (uint8_t f = 0; f < (search.edges_all0 ? 1 : 2); f++)
+            {
+                const uint64_t key = (uint64_t)((uint32_t)(original_states[i])) << 1 | f;
+
+                if (bidirectional_solved(&search, key))
+                    enough_memory &= bidirectional_push(backward, key, 0, BIDIRECTIONAL_NONE);
+            }
+        }
+
+        for (uint8_t depth = 0; enough_memory && depth < goal_depth; depth++)
+            enough_memory &= bidirectional_backward(&search, backward + depth, backward + depth + 1);
+
+        for (uint8_t depth = 0; enough_memory && depth <= goal_depth; depth++)
+            qsort(backward[depth].nodes, backward[depth].size, sizeof(BidirectionalNode), bidirectional_compare);
+
+        if (enough_memory && goal_cache != NULL && !goal_cache_save(goal_cache, signature, goal_depth, backward))
+            printf("Failed to write goal cache: %s\n", goal_cache);
+    }
+
+    for (uint8_t depth = 0; enough_memory && depth <= goal_depth; depth++)
+        printf("goal depth %d: %zu backward paths%s\n", depth, backward[depth].size, cached ? " (cached)" : "");
+
+    if (!enough_memory)
+        printf("Failed to expand the paths: out of memory\n");
+
+    for (uint8_t length = min_depth > 1 ? min_depth : 1; enough_memory && length <= max_depth; length++)
+    {
+        const uint8_t backward_depth = length < goal_depth ? length : goal_depth;
+
+        bidirectional_join(&search, forward + length - backward_depth, backward + backward_depth, length - backward_depth, backward_depth);
+    }
+
+    for (uint8_t depth = 0; depth <= BIDIRECTIONAL_MAX_DEPTH / 2; depth++)
+    {
+        free(forward[depth].nodes);
+        free(backward[depth].nodes);
+    }
+
+    printf("search end in %lf (s), find total %u solutions: ", (get_current_time() - current_time) / 1000.0, search.solution_count);
+}
@@ -0,0 +1,261 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cube_rank.h"
+
+/**
+ *                       Selects the n-th smallest value left in a bit set.
+ *
+ * @param unused                The bit set of values not taken yet.
+ * @param n                     Which of the remaining values to select (0 is the smallest).
+ *
+ * @return                      The selected value.
+ */
+static inline uint8_t select_unused(uint32_t unused, uint8_t n)
+{
+    while (n-- > 0)
+        unused &= unused - 1;
+
+    return __builtin_ctz(unused);
+}
+
+/**
+ *                       Checks if a packed state is a legal cube.
+ *
+ * A legal packed state holds every corner exactly once, and either every edge exactly
+ * once or all edges set to zero (edges ignored).
+ *
+ * @param state                 The packed state to check.
+ *
+ * @return                      True if the state can be ranked, false otherwise.
+ */
+bool cube_state_valid(uint32_t state)
+{
+    uint32_t corners = 0, edges = 0;
+
+    for (uint8_t i = 0; i < 8; i++)
+        corners |= 1u << (state >> (29 - 3 * i) & 0b111);
+
+    for (uint8_t i = 0; i < 4; i++)
+        edges |= 1u << (state >> (6 - 2 * i) & 0b11);
+
+    return corners == 0xff && (edges == 0xf || (state & 0xff) == 0);
+}
+
+/**
+ *                       Ranks the corner permutation of a packed state.
+ *
+ * Each digit of the Lehmer code counts the corners not placed yet that are smaller than
+ * the current one, the digits are then read as a mixed radix (factorial base) number.
+ *
+ * @param state                 The packed state.
+ *
+ * @return                      The Lehmer code of the corners, in [0, CUBE_CORNERS_SIZE).
+ */
+uint32_t corners_rank(uint32_t state)
+{
+    uint32_t rank = 0, seen = 0;
+
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        const uint32_t c = state >> (29 - 3 * i) & 0b111;
+
+        rank = rank * (8 - i) + c - __builtin_popcount(seen & ((1u << c) - 1));
+        seen |= 1u << c;
+    }
+
+    return rank;
+}
+
+/**
+ *                       Builds the packed state of a corner rank, edges are set to zero.
+ *
+ * @param index                 The Lehmer code of the corners, in [0, CUBE_CORNERS_SIZE).
+ *
+ * @return                      The packed state with all edges set to zero.
+ */
+uint32_t corners_unrank(uint32_t index)
+{
+    uint8_t digits[8];
+    uint32_t unused = 0xff, state = 0;
+
+    for (int8_t i = 7; i >= 0; i--)
+    {
+        digits[i] = index % (8 - i);
+        index /= 8 - i;
+    }
+
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        const uint8_t c = select_unused(unused, digits[i]);
+
+        unused &= ~(1u << c);
+        state = state << 3 | c;
+    }
+
+    return state << 8;
+}
+
+/**
+ *                       Ranks the edge permutation of a packed state.
+ *
+ * @param state                 The packed state.
+ *
+ * @return                      The Lehmer code of the edges, in [0, CUBE_EDGES_SIZE).
+ */
+uint32_t edges_rank(uint32_t state)
+{
+    uint32_t rank = 0, seen = 0;
+
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        const uint32_t e = state >> (6 - 2 * i) & 0b11;
+
+        rank = rank * (4 - i) + e - __builtin_popcount(seen & ((1u << e) - 1));
+        seen |= 1u << e;
+    }
+
+    return rank;
+}
+
+/**
+ *                       Builds the edge bits of an edge rank.
+ *
+ * @param index                 The Lehmer code of the edges, in [0, CUBE_EDGES_SIZE).
+ *
+ * @return                      The lowest 8 bits of a packed state.
+ */
+uint32_t edges_unrank(uint32_t index)
+{
+    uint8_t digits[4];
+    uint32_t unused = 0xf, state = 0;
+
+    for (int8_t i = 3; i >= 0; i--)
+    {
+        digits[i] = index % (4 - i);
+        index /= 4 - i;
+    }
+
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        const uint8_t e = select_unused(unused, digits[i]);
+
+        unused &= ~(1u << e);
+        state = state << 2 | e;
+    }
+
+    return state;
+}
+
+/**
+ *                       Extracts the edge flip of an edge phase.
+ *
+ * Edge position i owns the phase bits 2i + 1 and 2i + 2 (mod 8). Edge piece k carries
+ * the colors k and k + 1 (Blue, Orange, Green, Red), so the color followed by the phase
+ * sits on piece c as its first color and on piece c - 1 as its second color. The half
+ * turns swap two neighbour positions and turn both pieces over, E turns keep every
+ * piece the right way up, so "piece c is upside down" xor "piece c is an odd number of
+ * positions away from home" is the same for every piece and every phase of a state.
+ *
+ * @param state                 The packed state.
+ * @param phase                 The edge phase, as built by edges_phase_convert.
+ *
+ * @return                      The edge flip, 0 or 1 (0 for the original states).
+ */
+uint8_t edges_flip(uint32_t state, uint8_t phase)
+{
+    const uint8_t facelet_a = __builtin_ctz(phase);
+    const uint8_t facelet_b = 31 - __builtin_clz(phase);
+    const uint8_t position_a = ((facelet_a + 7) & 7) >> 1;
+    const uint8_t position_b = ((facelet_b + 7) & 7) >> 1;
+    const uint8_t piece_a = state >> (6 - 2 * position_a) & 0b11;
+    const uint8_t piece_b = state >> (6 - 2 * position_b) & 0b11;
+
+    // piece c holds the color as its first color, piece c - 1 as its second color
+    const bool a_first = ((piece_a + 3) & 3) == piece_b;
+    const uint8_t color = a_first ? piece_a : piece_b;
+    const uint8_t position = a_first ? position_a : position_b;
+    const uint8_t facelet = a_first ? facelet_a : facelet_b;
+    const uint8_t upside_down = facelet != 2 * position + 1;
+
+    return upside_down ^ ((position ^ color) & 1);
+}
+
+/**
+ *                       Builds the edge phase of a packed state and an edge flip.
+ *
+ * @param state                 The packed state.
+ * @param flip                  The edge flip, 0 or 1.
+ *
+ * @return                      The edge phase following the Blue color.
+ */
+uint8_t edges_phase(uint32_t state, uint8_t flip)
+{
+    uint8_t position_0 = 0, position_3 = 0;
+
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        const uint8_t piece = state >> (6 - 2 * i) & 0b11;
+
+        if (piece == 0) position_0 = i;
+        else if (piece == 3) position_3 = i;
+    }
+
+    // Blue is the first color of piece 0 and the second color of piece 3
+    const uint8_t upside_down_0 = flip ^ (position_0 & 1);
+    const uint8_t upside_down_3 = flip ^ ((position_3 ^ 3) & 1);
+    const uint8_t facelet_0 = upside_down_0 ? (2 * position_0 + 2) & 7 : 2 * position_0 + 1;
+    const uint8_t facelet_3 = upside_down_3 ? 2 * position_3 + 1 : (2 * position_3 + 2) & 7;
+
+    return 1 << facelet_0 | 1 << facelet_3;
+}
+
+/**
+ *                       Ranks a packed state, ignoring the edge phase.
+ *
+ * @param state                 The packed state, every edge must be present.
+ *
+ * @return                      The rank, in [0, CUBE_STATES_SIZE).
+ */
+uint32_t cube_state_rank(uint32_t state)
+{
+    return corners_rank(state) * CUBE_EDGES_SIZE + edges_rank(state);
+}
+
+/**
+ *                       Builds the packed state of a rank from cube_state_rank.
+ *
+ * @param index                 The rank, in [0, CUBE_STATES_SIZE).
+ *
+ * @return                      The packed state.
+ */
+uint32_t cube_state_unrank(uint32_t index)
+{
+    return corners_unrank(index / CUBE_EDGES_SIZE) | edges_unrank(index % CUBE_EDGES_SIZE);
+}
+
+/**
+ *                       Ranks a packed state together with its edge phase.
+ *
+ * @param state                 The packed state, every edge must be present.
+ * @param phase                 The edge phase, as built by edges_phase_convert.
+ *
+ * @return                      The rank, in [0, CUBE_PHASE_STATES_SIZE).
+ */
+uint32_t cube_rank(uint32_t state, uint8_t phase)
+{
+    return cube_state_rank(state) << 1 | edges_flip(state, phase);
+}
+
+/**
+ *                       Builds the packed state and the edge phase of a rank from cube_rank.
+ *
+ * @param index                 The rank, in [0, CUBE_PHASE_STATES_SIZE).
+ * @param state                 Where to store the packed state.
+ * @param phase                 Where to store the edge phase (following the Blue color).
+ */
+void cube_unrank(uint32_t index, uint32_t* state, uint8_t* phase)
+{
+    *state = cube_state_unrank(index >> 1);
+    *phase = edges_phase(*state, index & 1);
+}
@@ -1,5 +1,6 @@
 #include <string.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -7,6 +8,18 @@
 #include "cube_solver.h"
 #include "bfs_solver.h"
 #include "dfs_solver.h"
+#include "move_table.h"
+#include "cube_rank.h"
+#include "cube_algebra.h"
+#include "move_dispatch.h"
+#include "macro_table.h"
+#include "distance_table.h"
+#include "ida_solver.h"
+#include "bidirectional_solver.h"
+#include "search_kernel.h"
+#include "move_canonical.h"
+#include "move_automaton.h"
+#include "move_constraint.h"
 
 /**
  *                       Converts a cube state to a human-readable string.
@@ -171,6 +184,80 @@ uint8_t edges_phase_convert(const uint8_t* edges)
     return 1 << edges[4] | 1 << edges[5];
 }
 
+/**
+ *                       Reads the corners and edges of a cube from a JSON object.
+ *
+ * @param json                  The JSON object holding the "corners" and "edges" arrays.
+ * @param name                  The name of the cube in the error messages ("" or "target.").
+ * @param corners               Where to store the 8 corners.
+ * @param edges                 Where to store the 4 edges and the 2 edge phase facelets.
+ * @param edges_all0            Where to store whether all edges are zero (edges ignored).
+ *
+ * @return                      True if both arrays are complete and the edge phase facelets are distinct bits, false otherwise.
+ */
+static bool cube_parse(const cJSON* json, const char* name, uint8_t* corners, uint8_t* edges, bool* edges_all0)
+{
+    const cJSON* corners_array_json = cJSON_GetObjectItemCaseSensitive(json, "corners");
+
+    if (corners_array_json == NULL)
+    {
+        printf("Invalid json format: %scorners not found\n", name);
+        return false;
+    }
+
+    const cJSON* edges_array_json = cJSON_GetObjectItemCaseSensitive(json, "edges");
+
+    if (edges_array_json == NULL)
+    {
+        printf("Invalid json format: %sedges not found\n", name);
+        return false;
+    }
+
+    *edges_all0 = true;
+
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        cJSON* item = cJSON_GetArrayItem(corners_array_json, i);
+
+        if (item == NULL)
+        {
+            printf("Invalid json format: %scorners[%d] not found\n", name, i);
+            return false;
+        }
+
+        corners[i] = item -> valueint;
+
+        if (i < 6)
+        {
+            item = cJSON_GetArrayItem(edges_array_json, i);
+
+            if (item == NULL)
+            {
+                printf("Invalid json format: %sedges[%d] not found\n", name, i);
+                return false;
+            }
+
+            edges[i] = item -> valueint;
+            *edges_all0 &= item -> valueint == 0;
+
+            // the edge phase is a bit per facelet of a byte, the ranks and the dedup keys need two distinct bits
+            if (i >= 4 && (item -> valueint < 0 || item -> valueint > 7))
+            {
+                printf("Invalid json format: %sedges[%d] must be between 0 and 7\n", name, i);
+                return false;
+            }
+        }
+    }
+
+    if (!*edges_all0 && edges[4] == edges[5])
+    {
+        printf("Invalid json format: %sedges[4] and %sedges[5] must be different\n", name, name);
+        return false;
+    }
+
+    return true;
+}
+
 /**
  *                       Solves a cube given its settings and configuration.
  *
@@ -181,13 +268,16 @@ uint8_t edges_phase_convert(const uint8_t* edges)
  * corners and edges of the cube. The "moves" and "moves_map" items must contain arrays of
  * strings, representing the moves and the moves map of the cube.
  *
+ * The optional "target" item holds the "corners" and "edges" of the cube to reach instead of
+ * a solved cube. The solvers then solve the state relative to the target.
+ *
  * @param json                  The JSON object containing the settings and configuration of the
  *                               cube.
  */
 void cube_solver(const cJSON* json)
 {
     const uint8_t moves_size = 19;
-    const Move ALL_MOVES[19] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2};
+    Move ALL_MOVES[19] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2};
     int CORNOR_ORIGINAL_STATES[8] = {};
     const int ALL_ORIGINAL_STATES[8] = {-1622093511, -1277027762, -697023597, -87652124, 87652123, 697023596, 1277027761, 1622093510};
 
@@ -210,22 +300,6 @@ void cube_solver(const cJSON* json)
         return;
     }
 
-    const cJSON* corners_array_json = cJSON_GetObjectItemCaseSensitive(json, "corners");
-
-    if (corners_array_json == NULL)
-    {
-        printf("Invalid json format: corners not found\n");
-        return;
-    }
-
-    const cJSON* edges_array_json = cJSON_GetObjectItemCaseSensitive(json, "edges");
-
-    if (edges_array_json == NULL)
-    {
-        printf("Invalid json format: edges not found\n");
-        return;
-    }
-
     /*const cJSON* moves_array_json = cJSON_GetObjectItemCaseSensitive(json, "moves");
 
     if (moves_array_json == NULL)
@@ -250,44 +324,117 @@ void cube_solver(const cJSON* json)
         return;
     }
 
-    const uint8_t max_depth = max_depth_json -> valueint;
-    const uint8_t min_depth = min_depth_json -> valueint;
-    const char* algorithm = algorithm_json -> valuestring;
-    bool algorithm_bfs = true;
+    // optional, "function" (default) calls the move functions, "table" walks a precomputed transition table,
+    // "symmetry" walks a transition table of the symmetry classes, "simd" expands the BFS frontier with the AVX2 batch kernels
+    const cJSON* engine_json = cJSON_GetObjectItemCaseSensitive(json, "engine");
+    const bool engine_symmetry = cJSON_IsString(engine_json) && strcmp(engine_json -> valuestring, "symmetry\0") == 0;
+    const bool engine_table = engine_symmetry || (cJSON_IsString(engine_json) && strcmp(engine_json -> valuestring, "table\0") == 0);
+    const bool engine_simd = cJSON_IsString(engine_json) && strcmp(engine_json -> valuestring, "simd\0") == 0;
 
-    uint8_t corners[8] = {0};
-    uint8_t edges[6] = {0};
-    Move moves[moves_size] = {};
-    Move moves_map[moves_size][moves_size] = {};
-    Move moves_map_1d[moves_size * moves_size] = {}; 
+    // optional, true steps the DFS by deduplicated 3-move macros
+    const bool use_macros = cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(json, "macro"));
 
-    bool edges_all0 = true;
+    // optional, false keeps moves_map as written instead of removing the runs of commuting moves that repeat another one
+    const bool use_canonical = !cJSON_IsFalse(cJSON_GetObjectItemCaseSensitive(json, "canonical"));
 
-    for (uint8_t i = 0; i < 8; i++)
+    // optional, 1 to AUTOMATON_MAX_LENGTH makes the BFS and the DFS skip every sequence of up to that many moves that
+    // reaches the same cube as an earlier one, 0 (default) walks moves_map
+    const cJSON* prune_json = cJSON_GetObjectItemCaseSensitive(json, "prune");
+    const uint8_t prune = !cJSON_IsNumber(prune_json) || prune_json -> valueint <= 0 ? 0 :
+                          prune_json -> valueint > AUTOMATON_MAX_LENGTH ? AUTOMATON_MAX_LENGTH : prune_json -> valueint;
+
+    // optional, patterns over move symbols every solution of the BFS and the DFS must match, "!" first for must not
+    const cJSON* constraints_json = cJSON_GetObjectItemCaseSensitive(json, "constraints");
+    uint8_t constraints_size = 0;
+
+    if (constraints_json != NULL && (!cJSON_IsArray(constraints_json) || cJSON_GetArraySize(constraints_json) > CONSTRAINT_MAX_SIZE))
     {
-        cJSON* item = cJSON_GetArrayItem(corners_array_json, i);
+        printf("Invalid json format: constraints must be an array of up to %d patterns\n", CONSTRAINT_MAX_SIZE);
+        return;
+    }
 
-        if (item == NULL)
+    for (int i = 0; constraints_json != NULL && i < cJSON_GetArraySize(constraints_json); i++)
+    {
+        if (!cJSON_IsString(cJSON_GetArrayItem(constraints_json, i)))
         {
-            printf("Invalid json format: corners[%d] not found\n", i);
+            printf("Invalid json format: constraints must be an array of up to %d patterns\n", CONSTRAINT_MAX_SIZE);
             return;
         }
 
-        corners[i] = item -> valueint;
+        constraints_size++;
+    }
 
-        if (i < 6)
-        {
-            item = cJSON_GetArrayItem(edges_array_json, i);
+    // optional, false makes the BFS and the DFS walk moves_map even if a kernel was generated for it at build time
+    const bool use_kernel = !cJSON_IsFalse(cJSON_GetObjectItemCaseSensitive(json, "kernel"));
 
-            if (item == NULL)
-            {
-                printf("Invalid json format: edges[%d] not found\n", i);
-                return;
-            }
+    // optional, true (or "first") makes the BFS skip the states it already queued, only the first path to every state
+    // is printed, "all" queues every state once but records all the shortest paths to it
+    const cJSON* dedup_json = cJSON_GetObjectItemCaseSensitive(json, "dedup");
+    const uint8_t dedup = cJSON_IsString(dedup_json) && strcmp(dedup_json -> valuestring, "all\0") == 0 ? BFS_DEDUP_ALL :
+                          cJSON_IsTrue(dedup_json) || (cJSON_IsString(dedup_json) && strcmp(dedup_json -> valuestring, "first\0") == 0) ?
+                          BFS_DEDUP_FIRST : BFS_DEDUP_NONE;
 
-            edges[i] = item -> valueint;
-            edges_all0 &= item -> valueint == 0;
+    // optional, how many threads build the distance table or run the BFS and the DFS, 0 (default) for one per CPU
+    const cJSON* threads_json = cJSON_GetObjectItemCaseSensitive(json, "threads");
+    const uint16_t threads = cJSON_IsNumber(threads_json) && threads_json -> valueint > 0 ? threads_json -> valueint : 0;
+
+    // optional, the CPUs the DFS threads are pinned to, thread i to affinity[i % size]
+    const cJSON* affinity_json = cJSON_GetObjectItemCaseSensitive(json, "affinity");
+    int affinity[255] = {0};
+    uint8_t affinity_size = 0;
+
+    for (uint16_t i = 0; cJSON_IsArray(affinity_json) && i < cJSON_GetArraySize(affinity_json) && i < 255; i++)
+    {
+        const cJSON* item = cJSON_GetArrayItem(affinity_json, i);
+
+        if (!cJSON_IsNumber(item) || item -> valueint < 0)
+        {
+            printf("Invalid json format: affinity must be an array of CPU numbers\n");
+            return;
         }
+
+        affinity[affinity_size++] = item -> valueint;
+    }
+
+    // optional, bidirectional only: the longest goal-side paths (default: half of max_depth), and the file
+    // they are kept in between queries
+    const cJSON* goal_depth_json = cJSON_GetObjectItemCaseSensitive(json, "goal_depth");
+    const cJSON* goal_cache_json = cJSON_GetObjectItemCaseSensitive(json, "goal_cache");
+    const char* goal_cache = cJSON_IsString(goal_cache_json) ? goal_cache_json -> valuestring : NULL;
+
+    // the fastest kernel of every move on this CPU, timed once at the first solve
+    move_dispatch_bind(ALL_MOVES, moves_size);
+
+    const uint8_t max_depth = max_depth_json -> valueint;
+    const uint8_t min_depth = min_depth_json -> valueint;
+    const uint8_t goal_depth = cJSON_IsNumber(goal_depth_json) && goal_depth_json -> valueint >= 0 ? goal_depth_json -> valueint : max_depth / 2;
+    const char* algorithm = algorithm_json -> valuestring;
+    bool algorithm_bfs = true;
+
+    uint8_t corners[8] = {0};
+    uint8_t edges[6] = {0};
+    Move moves[moves_size];
+    Move moves_map[moves_size][moves_size];
+    Move moves_map_1d[moves_size * moves_size];
+
+    bool edges_all0 = true;
+
+    if (!cube_parse(json, "", corners, edges, &edges_all0))
+        return;
+
+    // optional, the cube to reach instead of a solved cube
+    const cJSON* target_json = cJSON_GetObjectItemCaseSensitive(json, "target");
+    uint8_t target_corners[8] = {0};
+    uint8_t target_edges[6] = {0};
+    bool target_edges_all0 = true;
+
+    if (target_json != NULL)
+    {
+        if (!cube_parse(target_json, "target.", target_corners, target_edges, &target_edges_all0))
+            return;
+
+        // the edges only count if both cubes give them
+        edges_all0 |= target_edges_all0;
     }
 
     for (uint8_t i = 0; i < moves_size; i++)
@@ -340,6 +487,19 @@ void cube_solver(const cJSON* json)
         }
     }
 
+    CanonicalStats canonical = {0};
+
+    if (use_canonical)
+    {
+        moves_map_canonical(moves_map_1d, &canonical);
+
+        for (uint8_t i = 0; i < moves_size; i++)
+        {
+            for (uint8_t j = 0; j < moves_size; j++)
+                moves_map[i][j] = moves_map_1d[i * moves_size + j];
+        }
+    }
+
     uint8_t first_valid_index = 0;
 
     for (uint8_t i = 0; i < moves_size; i++)
@@ -351,7 +511,7 @@ void cube_solver(const cJSON* json)
     const uint8_t moves_bits = first_valid_index == 0 ? 1 : log2(first_valid_index) + 1;
     const uint8_t moves_mask = (1 << moves_bits) - 1;
 
-    char content[1024] = "solve settings: \n\0";
+    char content[4096] = "solve settings: \n\0";
 
     char separate_line[65] = "\0";
 
@@ -364,7 +524,70 @@ void cube_solver(const cJSON* json)
     if (strcmp(algorithm, "dfs\0") == 0 || strcmp(algorithm, "DFS\0") == 0)
         algorithm_bfs = false;
 
-    sprintf(content + strlen(content), "algorithm: %s\n", algorithm_bfs ? "BFS" : "DFS");
+    // builds the distance of every state, then prints the optimal solutions
+    const bool algorithm_distance = strcmp(algorithm, "distance\0") == 0;
+
+    if (algorithm_distance)
+        algorithm_bfs = false;
+
+    // iterative deepening DFS, cut by the corner and edge pattern databases
+    const bool algorithm_ida = strcmp(algorithm, "ida*\0") == 0 || strcmp(algorithm, "IDA*\0") == 0;
+
+    if (algorithm_ida)
+        algorithm_bfs = false;
+
+    // half-depth searches from the cube and from the original states, joined on the cube they meet
+    const bool algorithm_bidirectional = strcmp(algorithm, "bidirectional\0") == 0;
+
+    if (algorithm_bidirectional)
+        algorithm_bfs = false;
+
+    sprintf(content + strlen(content), "algorithm: %s\n", algorithm_distance ? "distance" : algorithm_ida ? "IDA*" : algorithm_bidirectional ? "bidirectional" : algorithm_bfs ? "BFS" : "DFS");
+    sprintf(content + strlen(content), "engine: %s\n", engine_symmetry ? "symmetry" : engine_table ? "table" : engine_simd ? "simd" : "function");
+    sprintf(content + strlen(content), "macro moves: %s\n", !use_macros ? "false" : algorithm_bfs || algorithm_distance || algorithm_ida || algorithm_bidirectional ? "DFS only, ignored" : "true");
+    sprintf(content + strlen(content), "dedup: %s\n", dedup == BFS_DEDUP_NONE ? "false" : !algorithm_bfs ? "BFS only, ignored" :
+            dedup == BFS_DEDUP_ALL ? "all" : "first");
+    // the automaton replaces moves_map in the BFS without dedup and in the DFS without macros
+    const bool automaton_search = !algorithm_distance && !algorithm_ida && !algorithm_bidirectional &&
+                                  (algorithm_bfs ? dedup == BFS_DEDUP_NONE : !use_macros);
+    // a pruned path may be the only one a constraint allows, so the constraints replace pruning
+    const bool use_constraints = constraints_size > 0 && automaton_search;
+    const bool use_automaton = (prune > 0 || use_constraints) && automaton_search;
+
+    if (prune == 0)
+        strcat(content, "prune: false\n");
+    else if (!automaton_search)
+        strcat(content, "prune: BFS without dedup and DFS without macros only, ignored\n");
+    else if (use_constraints)
+        strcat(content, "prune: replaced by the constraints, ignored\n");
+    else
+        sprintf(content + strlen(content), "prune: sequences of up to %d moves\n", prune);
+
+    if (constraints_size == 0)
+        strcat(content, "constraints: false\n");
+    else if (!use_constraints)
+        strcat(content, "constraints: BFS without dedup and DFS without macros only, ignored\n");
+    else
+    {
+        strcat(content, "constraints:");
+
+        for (uint8_t i = 0; i < constraints_size && strlen(content) < sizeof(content) - 128; i++)
+            sprintf(content + strlen(content), " \"%.96s\"", cJSON_GetArrayItem(constraints_json, i) -> valuestring);
+
+        strcat(content, "\n");
+    }
+
+    // the generated kernels walk packed states one by one
+    const SearchKernel* kernel = use_kernel && !use_automaton && !algorithm_distance && !algorithm_ida && !algorithm_bidirectional &&
+                                 !engine_table && !(algorithm_bfs ? engine_simd : use_macros) ? search_kernel_find(moves_map_1d) : NULL;
+
+    sprintf(content + strlen(content), "search kernel: %s\n", kernel != NULL ? kernel -> name : "generic");
+    sprintf(content + strlen(content), "canonical: %s", use_canonical ? "" : "false\n");
+
+    if (use_canonical)
+        sprintf(content + strlen(content), "%d commuting classes, %d successors removed (%d allowed in both orders)\n",
+                canonical.classes, canonical.removed, canonical.both_orders);
+
     sprintf(content + strlen(content), "min depth: %d\n", min_depth);
     sprintf(content + strlen(content), "max depth: %d\n", max_depth);
     strcat(content, "corners: ");
@@ -379,6 +602,21 @@ void cube_solver(const cJSON* json)
 
     strcat(content, "\n");
 
+    if (target_json != NULL)
+    {
+        strcat(content, "target corners: ");
+
+        for (uint8_t i = 0; i < 8; i++)
+            sprintf(content + strlen(content), "%d ", target_corners[i]);
+
+        strcat(content, "\ntarget edges: ");
+
+        for (uint8_t i = 0; i < 6; i++)
+            sprintf(content + strlen(content), "%d ", target_edges[i]);
+
+        strcat(content, "\n");
+    }
+
     sprintf(content + strlen(content), "ignore edges: %s\n", edges_all0 ? "true\0" : "false\0");
     sprintf(content + strlen(content), "moves bits: %d\n", moves_bits);
     sprintf(content + strlen(content), "moves musk: %x\n", moves_mask);
@@ -387,6 +625,14 @@ void cube_solver(const cJSON* json)
     for (uint8_t i = 0; i < moves_size; i++)
         sprintf(content + strlen(content), "%s ", moves[i].symbol);
 
+    strcat(content, "\nkernels: ");
+
+    for (uint8_t i = 0; i < moves_size; i++)
+    {
+        if (moves[i].transform != NULL)
+            sprintf(content + strlen(content), "%s:%s ", moves[i].symbol, move_dispatch_name(moves[i].serial, engine_simd));
+    }
+
     strcat(content, "\nmoves_map:\n");
 
     for (uint8_t i = 0; i < moves_size; i++)
@@ -395,7 +641,8 @@ void cube_solver(const cJSON* json)
 
         while (true)
         {
-            if (moves_map[i][index].transform == NULL)
+            // a row may hold all 19 moves
+            if (index == moves_size || moves_map[i][index].transform == NULL)
                 break;
                 
             sprintf(content + strlen(content), "%s ", moves_map[i][index].symbol);
@@ -408,6 +655,35 @@ void cube_solver(const cJSON* json)
     uint32_t state = cube_convert((const uint8_t*)(corners), (const uint8_t*)(edges));
     uint8_t edges_phase_state = edges_phase_convert((const uint8_t*)(edges));
     sprintf(content + strlen(content), "\n\ncube_state: %d, phase: %d\n", state, edges_phase_state);
+
+    if (target_json != NULL)
+    {
+        uint32_t target_state = cube_convert((const uint8_t*)(target_corners), (const uint8_t*)(target_edges));
+        const uint8_t target_phase = edges_phase_convert((const uint8_t*)(target_edges));
+
+        if (edges_all0)
+        {
+            state &= 0xffffff00;
+            target_state &= 0xffffff00;
+        }
+
+        if (!cube_state_valid(state) || !cube_state_valid(target_state))
+        {
+            printf("Invalid cube: start %u or target %u is not a legal cube\n", state, target_state);
+            return;
+        }
+
+        // solving start to target is solving inverse(target) after start to the original states
+        if (!edges_all0)
+            edges_phase_state = cube_relative_phase(state, edges_phase_state, target_state, target_phase);
+
+        state = cube_relative(state, target_state);
+        sprintf(content + strlen(content), "target_state: %d, phase: %d\nrelative_state: %d, phase: %d\n",
+                target_state, target_phase, state, edges_phase_state);
+    }
+
+    if (!edges_all0 && cube_state_valid(state))
+        sprintf(content + strlen(content), "cube_rank: %u\n", cube_rank(state, edges_phase_state));
     
     for (uint8_t i = 0; i < 64; i++)
         strcat(content, "-\0");
@@ -418,8 +694,211 @@ void cube_solver(const cJSON* json)
     cube_state(NULL, state);
     puts(separate_line);
 
+    if (algorithm_distance)
+    {
+        DistanceTable distances;
+        uint64_t current_time = get_current_time();
+
+        if (!distance_table_create(&distances, moves_map_1d, original_states, threads))
+        {
+            printf("Failed to build distance table: out of memory\n");
+            return;
+        }
+
+        printf("distance table: %u states x %d move classes (%zu KB) built in %lf (s) with %d threads\n", distances.size,
+               distances.classes, ((size_t)(distances.classes) * distances.size + 1) / 2 / 1024,
+               (get_current_time() - current_time) / 1000.0, distances.threads);
+
+        for (uint8_t i = 0; i <= distances.depth; i++)
+            printf("distance %d: %u states%s\n", i, distances.count[i], i > 0 && distances.bottom_up[i - 1] ? " (bottom-up)" : "");
+
+        cube_distance_solver(&distances, state, edges_phase_state, min_depth, max_depth);
+        distance_table_free(&distances);
+        return;
+    }
+
+    if (algorithm_bidirectional)
+    {
+        printf("goal depth: %d, goal cache: %s\n", goal_depth, goal_cache != NULL ? goal_cache : "none");
+        cube_bidirectional_solver(moves_map_1d, original_states, state, edges_phase_state, min_depth, max_depth,
+                                  goal_depth, goal_cache);
+        return;
+    }
+
+    if (algorithm_ida)
+    {
+        DistanceTable corners_distances, edges_distances;
+        int EDGES_ORIGINAL_STATES[8] = {};
+        uint64_t current_time = get_current_time();
+
+        for (uint8_t i = 0; i < 8; i++)
+            EDGES_ORIGINAL_STATES[i] = ALL_ORIGINAL_STATES[i] & 0xff;
+
+        if (!distance_table_create(&corners_distances, moves_map_1d, CORNOR_ORIGINAL_STATES, threads))
+        {
+            printf("Failed to build pattern databases: out of memory\n");
+            return;
+        }
+
+        if (!edges_all0 && !distance_table_create(&edges_distances, moves_map_1d, EDGES_ORIGINAL_STATES, threads))
+        {
+            printf("Failed to build pattern databases: out of memory\n");
+            distance_table_free(&corners_distances);
+            return;
+        }
+
+        printf("pattern databases: %u corner states, %u edge states x %d move classes built in %lf (s)\n",
+               corners_distances.size, edges_all0 ? 0 : edges_distances.size, corners_distances.classes,
+               (get_current_time() - current_time) / 1000.0);
+
+        cube_ida_solver(moves_map_1d, original_states, state, edges_phase_state, min_depth, max_depth,
+                        &corners_distances, edges_all0 ? NULL : &edges_distances);
+        distance_table_free(&corners_distances);
+
+        if (!edges_all0)
+            distance_table_free(&edges_distances);
+
+        return;
+    }
+
+    MoveTable table;
+    MoveTable* table_ptr = NULL;
+
+    if (engine_table)
+    {
+        uint64_t current_time = get_current_time();
+
+        if (!move_table_create(&table, original_states, engine_symmetry))
+        {
+            printf("Failed to build transition table: out of memory\n");
+            return;
+        }
+
+        if (move_table_index(&table, state) < 0)
+        {
+            printf("Invalid cube: state %u is not a legal cube\n", state);
+            move_table_free(&table);
+            return;
+        }
+
+        printf("transition table: %u %s built in %lf (s)\n", table.size, engine_symmetry ? "symmetry classes" : "states",
+               (get_current_time() - current_time) / 1000.0);
+        table_ptr = &table;
+    }
+
+    MacroTable macros;
+    MacroTable* macros_ptr = NULL;
+
+    if (use_macros && !algorithm_bfs)
+    {
+        uint64_t current_time = get_current_time();
+
+        if (!macro_table_create(&macros, moves_map_1d, MACRO_MAX_LENGTH, edges_all0))
+        {
+            printf("Failed to build macro moves: out of memory\n");
+
+            if (table_ptr != NULL)
+                move_table_free(table_ptr);
+
+            return;
+        }
+
+        printf("macro moves: %u of %u 2-move and %u of %u 3-move sequences kept in %lf (s)\n",
+               macros.distinct[1], macros.sequences[1], macros.distinct[2], macros.sequences[2],
+               (get_current_time() - current_time) / 1000.0);
+        macros_ptr = &macros;
+    }
+
+    MoveAutomaton automaton;
+    MoveAutomaton* automaton_ptr = NULL;
+
+    if (use_constraints)
+    {
+        uint64_t current_time = get_current_time();
+        MoveConstraint constraints[CONSTRAINT_MAX_SIZE];
+        char error[128];
+        uint32_t states = 1;
+
+        for (uint8_t i = 0; i < constraints_size; i++)
+        {
+            if (!move_constraint_compile(&constraints[i], cJSON_GetArrayItem(constraints_json, i) -> valuestring, error))
+            {
+                printf("Invalid json format: constraints[%d]: %s\n", i, error);
+
+                for (uint8_t j = 0; j < i; j++)
+                    move_constraint_free(&constraints[j]);
+
+                if (table_ptr != NULL)
+                    move_table_free(table_ptr);
+
+                return;
+            }
+
+            states *= constraints[i].size;
+
+            if (states > CONSTRAINT_MAX_PRODUCT)
+                states = CONSTRAINT_MAX_PRODUCT;
+        }
+
+        const bool built = move_automaton_constrain(&automaton, moves_map_1d, constraints, constraints_size);
+
+        for (uint8_t i = 0; i < constraints_size; i++)
+            move_constraint_free(&constraints[i]);
+
+        if (!built)
+        {
+            printf("Failed to build constraint automaton: out of memory or more than %d states\n", CONSTRAINT_MAX_PRODUCT);
+
+            if (table_ptr != NULL)
+                move_table_free(table_ptr);
+
+            return;
+        }
+
+        printf("constraint automaton: %u states of up to %u built in %lf (s)\n", automaton.size, 20 * states,
+               (get_current_time() - current_time) / 1000.0);
+
+        for (uint8_t i = 0; i < AUTOMATON_MAX_LENGTH; i++)
+            printf("paths of %d moves: %" PRIu64 " of %" PRIu64 " kept\n", i + 1, automaton.kept[i], automaton.sequences[i]);
+
+        automaton_ptr = &automaton;
+    }
+    else if (use_automaton)
+    {
+        uint64_t current_time = get_current_time();
+
+        if (!move_automaton_create(&automaton, moves_map_1d, prune, edges_all0))
+        {
+            printf("Failed to build pruning automaton: out of memory\n");
+
+            if (table_ptr != NULL)
+                move_table_free(table_ptr);
+
+            return;
+        }
+
+        printf("pruning automaton: %u states from %u sequences built in %lf (s)\n", automaton.size, automaton.nodes,
+               (get_current_time() - current_time) / 1000.0);
+
+        for (uint8_t i = 0; i < AUTOMATON_MAX_LENGTH; i++)
+            printf("paths of %d moves: %" PRIu64 " of %" PRIu64 " kept\n", i + 1, automaton.kept[i], automaton.sequences[i]);
+
+        automaton_ptr = &automaton;
+    }
+
     if (algorithm_bfs)
-        cube_bfs_solver(moves, moves_map_1d, original_states, state, edges_phase_state, min_depth, max_depth);
+        cube_bfs_solver(moves, moves_map_1d, original_states, state, edges_phase_state, min_depth, max_depth, table_ptr, engine_simd,
+                        kernel, automaton_ptr, threads, dedup);
     else
-        cube_dfs_solver(moves, moves_map_1d, original_states, state, edges_phase_state, min_depth, max_depth);
+        cube_dfs_solver(moves, moves_map_1d, original_states, state, edges_phase_state, min_depth, max_depth, table_ptr, macros_ptr,
+                        automaton_ptr, kernel, threads, affinity, affinity_size);
+
+    if (automaton_ptr != NULL)
+        move_automaton_free(automaton_ptr);
+
+    if (table_ptr != NULL)
+        move_table_free(table_ptr);
+
+    if (macros_ptr != NULL)
+        macro_table_free(macros_ptr);
 }
\ No newline at end of file
@@ -0,0 +1,261 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "cube_symmetry.h"
+#include "cube_rank.h"
+
+CubeSymmetry CUBE_SYMMETRY[CUBE_SYMMETRIES];
+uint8_t CUBE_SYMMETRY_PRODUCT[CUBE_SYMMETRIES][CUBE_SYMMETRIES];
+
+// corners: 0 - 3 top front-left, back-left, back-right, front-right, 4 - 7 below them
+// edges: front-left, back-left, back-right, front-right; facelets: 2 * edge + 1 and 2 * edge + 2
+static const CubeSymmetry SYMMETRY_GENERATORS[3] =
+{
+    // quarter turn of the whole cube around the U - D axis, the ring moves by one position
+    {.mirror = false, .corners = {1, 2, 3, 0, 5, 6, 7, 4}, .edges = {1, 2, 3, 0}, .facelets = {2, 3, 4, 5, 6, 7, 0, 1}},
+    // half turn around the front-left / back-right axis, U and D are swapped
+    {.mirror = false, .corners = {4, 7, 6, 5, 0, 3, 2, 1}, .edges = {0, 3, 2, 1}, .facelets = {3, 2, 1, 0, 7, 6, 5, 4}},
+    // mirror swapping the left and right faces
+    {.mirror = true, .corners = {3, 2, 1, 0, 7, 6, 5, 4}, .edges = {3, 2, 1, 0}, .facelets = {1, 0, 7, 6, 5, 4, 3, 2}}
+};
+
+/**
+ *                       Composes two symmetries.
+ *
+ * @param a                     The symmetry applied second.
+ * @param b                     The symmetry applied first.
+ *
+ * @return                      The symmetry conjugating by b, then by a.
+ */
+static CubeSymmetry symmetry_compose(const CubeSymmetry* a, const CubeSymmetry* b)
+{
+    CubeSymmetry result = {.mirror = a -> mirror != b -> mirror};
+
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        result.corners[i] = a -> corners[b -> corners[i]];
+        result.facelets[i] = a -> facelets[b -> facelets[i]];
+    }
+
+    for (uint8_t i = 0; i < 4; i++)
+        result.edges[i] = a -> edges[b -> edges[i]];
+
+    return result;
+}
+
+/**
+ *                       Finds a symmetry among the first ones built.
+ *
+ * @param symmetry              The symmetry to find.
+ * @param size                  How many symmetries are built.
+ *
+ * @return                      The index of the symmetry, or size if it is a new one.
+ */
+static uint8_t symmetry_find(const CubeSymmetry* symmetry, uint8_t size)
+{
+    for (uint8_t i = 0; i < size; i++)
+    {
+        if (memcmp(CUBE_SYMMETRY[i].corners, symmetry -> corners, 8) == 0 &&
+            memcmp(CUBE_SYMMETRY[i].edges, symmetry -> edges, 4) == 0 &&
+            memcmp(CUBE_SYMMETRY[i].facelets, symmetry -> facelets, 8) == 0)
+            return i;
+    }
+
+    return size;
+}
+
+/**
+ *                       Builds the symmetries of the 223 cube.
+ *
+ * The 16 symmetries are generated by a quarter turn of the whole cube around the U - D
+ * axis, a half turn around the horizontal axis through the front-left and back-right
+ * edges, and the mirror swapping the left and right faces. For every symmetry, the move
+ * of every serial is mapped to the move doing the same on the conjugated cube. Calling
+ * it again does nothing.
+ */
+void cube_symmetry_init()
+{
+    static bool initialized = false;
+    const Move ALL_MOVES[19] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2};
+
+    if (initialized)
+        return;
+
+    // the identity, then closing the generators under composition
+    CubeSymmetry identity = {.mirror = false, .corners = {0, 1, 2, 3, 4, 5, 6, 7}, .edges = {0, 1, 2, 3},
+                             .facelets = {0, 1, 2, 3, 4, 5, 6, 7}};
+    uint8_t size = 1;
+
+    CUBE_SYMMETRY[0] = identity;
+
+    for (uint8_t i = 0; i < size; i++)
+    {
+        for (uint8_t j = 0; j < 3; j++)
+        {
+            const CubeSymmetry symmetry = symmetry_compose(SYMMETRY_GENERATORS + j, CUBE_SYMMETRY + i);
+
+            if (symmetry_find(&symmetry, size) == size)
+                CUBE_SYMMETRY[size++] = symmetry;
+        }
+    }
+
+    for (uint8_t a = 0; a < CUBE_SYMMETRIES; a++)
+    {
+        for (uint8_t b = 0; b < CUBE_SYMMETRIES; b++)
+        {
+            const CubeSymmetry symmetry = symmetry_compose(CUBE_SYMMETRY + a, CUBE_SYMMETRY + b);
+            CUBE_SYMMETRY_PRODUCT[a][b] = symmetry_find(&symmetry, CUBE_SYMMETRIES);
+
+            if (CUBE_SYMMETRY_PRODUCT[a][b] == CUBE_SYMMETRY_IDENTITY)
+                CUBE_SYMMETRY[a].inverse = b;
+        }
+    }
+
+    initialized = true;
+
+    // scrambled test states, a move is mapped to the one that agrees on all of them
+    uint32_t states[3] = {87652123, 87652123, 87652123};
+    uint8_t phases[3] = {3, 3, 3};
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        for (uint8_t j = 0; j < 7 + 4 * i; j++)
+        {
+            const uint8_t serial = (5 * j + 7 * i + 3) % 19;
+
+            states[i] = ALL_MOVES[serial].transform(states[i]);
+            phases[i] = edge_transform(phases[i], serial);
+        }
+    }
+
+    for (uint8_t s = 0; s < CUBE_SYMMETRIES; s++)
+    {
+        for (uint8_t serial = 0; serial < 19; serial++)
+        {
+            for (uint8_t mapped = 0; mapped < 19; mapped++)
+            {
+                bool same = true;
+
+                for (uint8_t i = 0; i < 3 && same; i++)
+                {
+                    const uint32_t moved = ALL_MOVES[serial].transform(states[i]);
+                    const uint32_t conjugated = cube_conjugate(states[i], s);
+
+                    same = cube_conjugate(moved, s) == ALL_MOVES[mapped].transform(conjugated) &&
+                           cube_conjugate_phase(moved, edge_transform(phases[i], serial), s) ==
+                           edge_transform(cube_conjugate_phase(states[i], phases[i], s), mapped);
+                }
+
+                if (same)
+                {
+                    CUBE_SYMMETRY[s].moves[serial] = mapped;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/**
+ *                       Conjugates a packed state by a symmetry.
+ *
+ * The cube is turned (or mirrored) by the symmetry, then its pieces are renamed after
+ * their new positions. Solved cubes stay solved, and applying a move to a state then
+ * conjugating is the same as conjugating then applying CUBE_SYMMETRY[symmetry].moves of
+ * that move. States with all edges set to zero (edges ignored) keep them at zero.
+ *
+ * @param state                 The packed state.
+ * @param symmetry              The symmetry, in [0, CUBE_SYMMETRIES).
+ *
+ * @return                      The conjugated packed state.
+ */
+uint32_t cube_conjugate(uint32_t state, uint8_t symmetry)
+{
+    const CubeSymmetry* s = CUBE_SYMMETRY + symmetry;
+    uint32_t result = 0;
+
+    for (uint8_t i = 0; i < 8; i++)
+        result |= (uint32_t)(s -> corners[state >> (29 - 3 * i) & 0b111]) << (29 - 3 * s -> corners[i]);
+
+    if ((state & 0xff) == 0)
+        return result;
+
+    for (uint8_t i = 0; i < 4; i++)
+        result |= (uint32_t)(s -> edges[state >> (6 - 2 * i) & 0b11]) << (6 - 2 * s -> edges[i]);
+
+    return result;
+}
+
+/**
+ *                       Conjugates an edge phase by a symmetry.
+ *
+ * @param state                 The packed state the phase belongs to, every edge must be present.
+ * @param phase                 The edge phase, as built by edges_phase_convert.
+ * @param symmetry              The symmetry, in [0, CUBE_SYMMETRIES).
+ *
+ * @return                      The edge phase (following the Blue color) of the conjugated state.
+ */
+uint8_t cube_conjugate_phase(uint32_t state, uint8_t phase, uint8_t symmetry)
+{
+    const CubeSymmetry* s = CUBE_SYMMETRY + symmetry;
+    const uint32_t conjugated = cube_conjugate(state, symmetry);
+    uint8_t result = 0;
+
+    // the facelets of the color Blue is sent to, the flip does not depend on the color
+    for (uint8_t i = 0; i < 8; i++)
+        result |= (phase >> i & 1) << s -> facelets[i];
+
+    return edges_phase(conjugated, edges_flip(conjugated, result));
+}
+
+/**
+ *                       Picks the representative of the symmetry class of a packed state.
+ *
+ * The representative is the smallest of the 16 conjugates of the state, so every state
+ * of a class gets the same one and tables can be keyed on it.
+ *
+ * @param state                 The packed state.
+ * @param symmetry              Where to store the symmetry conjugating state into the
+ *                               representative, or NULL.
+ *
+ * @return                      The representative packed state.
+ */
+uint32_t cube_canonical(uint32_t state, uint8_t* symmetry)
+{
+    uint32_t result = state;
+    uint8_t best = CUBE_SYMMETRY_IDENTITY;
+
+    for (uint8_t i = 1; i < CUBE_SYMMETRIES; i++)
+    {
+        const uint32_t conjugated = cube_conjugate(state, i);
+
+        if (conjugated < result)
+        {
+            result = conjugated;
+            best = i;
+        }
+    }
+
+    if (symmetry != NULL)
+        *symmetry = best;
+
+    return result;
+}
+
+/**
+ *                       Maps a sequence of moves back through a symmetry.
+ *
+ * If the moves solve the conjugate of a state by symmetry, the mapped moves solve the
+ * state itself.
+ *
+ * @param serials               The serials of the moves, replaced by the mapped serials.
+ * @param size                  How many moves.
+ * @param symmetry              The symmetry the moves were found for.
+ */
+void cube_symmetry_map_moves(uint8_t* serials, uint8_t size, uint8_t symmetry)
+{
+    const CubeSymmetry* inverse = CUBE_SYMMETRY + CUBE_SYMMETRY[symmetry].inverse;
+
+    for (uint8_t i = 0; i < size; i++)
+        serials[i] = inverse -> moves[serials[i]];
+}
@@ -1,235 +1,625 @@
+#define _GNU_SOURCE // pthread_setaffinity_np
+
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <sched.h>
+#include <unistd.h>
 
 #include "dfs_solver.h"
 
+typedef struct dfs_stack
+{
+    uint8_t path[DFS_MAX_DEPTH]; // the serials of the moves played
+    uint64_t states[DFS_MAX_DEPTH]; // states[d]: the state after d moves (dense index when walking a transition table)
+    uint8_t phases[DFS_MAX_DEPTH]; // phases[d]: the edge phase after d moves
+    uint8_t cursors[DFS_MAX_DEPTH]; // cursors[d]: the index of the next move to try in the moves_map row of path[d - 1]
+    uint32_t contexts[DFS_MAX_DEPTH]; // contexts[d]: the automaton state after d moves, when walking an automaton
+} DfsStack;
+
+typedef struct dfs_task
+{
+    uint64_t state; // the state after the path (dense index when walking a transition table)
+    uint8_t phase; // the edge phase after the path
+    uint8_t size; // how many moves the path holds
+    uint8_t path[DFS_SPLIT_DEPTH]; // the serials of the moves
+    uint32_t context; // the automaton state after the path, unused without an automaton
+} DfsTask;
+
+typedef struct dfs_deque
+{
+    DfsTask* tasks; // a ring buffer
+    size_t head; // the oldest task, stolen by the other threads
+    size_t size;
+    size_t capacity;
+    pthread_mutex_t lock;
+} DfsDeque;
+
+typedef struct dfs_pool DfsPool;
+
+typedef struct dfs_worker
+{
+    DfsPool* pool;
+    uint16_t id;
+    DfsDeque deque;
+    DfsSolutions solutions;
+    uint32_t steals; // how many tasks the thread took from the others
+} DfsWorker;
+
+struct dfs_pool
+{
+    const Move* moves_map;
+    const int* original_states;
+    const MoveTable* table;
+    const SearchKernel* kernel; // NULL if moves_map has no generated kernel
+    const MoveAutomaton* automaton; // stepped instead of moves_map, NULL if none
+    bool edges_all0;
+    uint8_t min_depth;
+    uint8_t max_depth;
+    uint16_t size; // how many workers
+    const int* affinity; // the CPU of every worker, or NULL
+    uint8_t affinity_size;
+    DfsWorker* workers;
+    int64_t pending; // the tasks pushed and not finished yet, the search ends at 0
+    bool out_of_memory;
+    pthread_mutex_t print_lock;
+};
+
 /**
- *                    Pushes a new node to the head of a move stack.
+ *                       Reports a solution.
  *
- * This function pushes a new node to the head of a move stack and sets the head and tail of the stack to that node.
+ * The solution is printed at once, or appended to the buffer of the thread, which is
+ * printed as a whole once it holds DFS_BUFFER_SIZE bytes.
  *
- * @param stack             The move stack to push the new node to.
- * @param move              The move to push to the stack.
+ * @param solutions             Where the solutions go.
+ * @param path                  The serials of the moves of the solution.
+ * @param size                  How many moves.
  */
-void move_list_push_head(MoveList* stack, Move move)
+static void dfs_report(DfsSolutions* solutions, const uint8_t* path, uint8_t size)
 {
-    MoveNode* node = (MoveNode*)(malloc(sizeof(MoveNode)));
-    node -> move = move;
-    node -> next = NULL;
-    node -> prev = NULL;
-
-    stack -> head = node;
-    stack -> last = node;
-    stack -> size = 1;
+    const Move ALL_MOVES[19] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2};
+    char string[1024] = "steps: \0";
+
+    for (uint8_t i = 0; i < size; i++)
+    {
+        strcat(string, ALL_MOVES[path[i]].symbol);
+        strcat(string, "\t\0");
+    }
+
+    solutions -> count++;
+
+    if (!solutions -> buffered)
+    {
+        puts(string);
+        return;
+    }
+
+    strcat(string, "\n");
+    strcpy(solutions -> text + solutions -> size, string);
+    solutions -> size += strlen(string);
+
+    // a line never exceeds 1024 bytes
+    if (solutions -> size + 1024 > DFS_BUFFER_SIZE)
+    {
+        pthread_mutex_lock(solutions -> print_lock);
+        fwrite(solutions -> text, 1, solutions -> size, stdout);
+        pthread_mutex_unlock(solutions -> print_lock);
+        solutions -> size = 0;
+    }
 }
 
 /**
- *                    Pushes a new node to the tail of a move stack.
- *
- * This function pushes a new node to the tail of a move stack and sets the tail of the stack to that node.
+ *                       Reports a solution found by a generated kernel.
  *
- * @param stack             The move stack to push the new node to.
- * @param move              The move to push to the stack.
+ * @param search                The kernel search, data is the DfsSolutions.
+ * @param size                  How many moves of search -> path.
  */
-void move_list_push(MoveList* stack, Move move)
+static void dfs_kernel_report(KernelSearch* search, uint8_t size)
 {
-    MoveNode* node = (MoveNode*)(malloc(sizeof(MoveNode)));
-    node -> move = move;
-    node -> next = NULL;
-    node -> prev = stack -> last;
-
-    stack -> last -> next = node;
-    stack -> last = node;
-    stack -> size++;
+    dfs_report((DfsSolutions*)(search -> data), search -> path, size);
 }
 
 /**
- *                       Pops the last node from a move stack.
+ *                       A helper function to perform DFS algorithm.
+ *
+ * This function searches every path that starts with the given moves, without recursion
+ * and without allocating: the moves, the states and the edge phases of the current path
+ * are kept per depth in DfsStack, together with a cursor into the moves_map row of the
+ * last move of every depth.
  *
- * This function pops the last node from a move stack, and decrements the size of the stack.
+ * If the state after a path is an original state (and the path is at least min_depth long),
+ * the function checks if the edge phase is solved and if so, reports the path. The path is
+ * never extended past an original state or past max_depth.
  *
- * @param stack             The move stack to pop the node from.
+ * With a generated kernel, the path is searched by the kernel instead, which hard-wires
+ * the moves_map rows and inlines the moves, in the same order.
+ *
+ * With a prune hook, a move is not played if the hook cuts the cube after it, given the
+ * moves left before max_depth. IDA* cuts the cubes whose lower bound does not fit.
+ *
+ * @param state                 The state of the cube after the first moves.
+ * @param edges_phase_state     The edge phase after the first moves, carried along with EDGE_PHASE_TABLE.
+ * @param edges_all0            A boolean indicating whether all edge phases are zero.
+ * @param moves                 The serials of the first moves, at least one.
+ * @param size                  How many first moves.
+ * @param moves_map             A 2D array of moves.
+ * @param original_states       An array of original states.
+ * @param min_depth             The minimum depth of the solution.
+ * @param max_depth             The maximum depth of the solution, less than DFS_MAX_DEPTH.
+ * @param solutions             Where the solutions go.
+ * @param table                 The transition table to walk instead of the move functions, or NULL.
+ *                               When given, state is a dense index instead of a packed state.
+ * @param kernel                The generated kernel of moves_map, or NULL (ignored with a table or a prune hook).
+ * @param prune                 The hook that cuts the paths, or NULL to search every path.
  */
-void move_list_pop(MoveList* stack)
+void dfs_iterator(uint64_t state, uint8_t edges_phase_state, bool edges_all0,
+                  const uint8_t* moves, uint8_t size, const Move* moves_map, const int* original_states,
+                  uint8_t min_depth, uint8_t max_depth, DfsSolutions* solutions, const MoveTable* table,
+                  const SearchKernel* kernel, const DfsPrune* prune)
 {
-    MoveNode* node = stack -> last;
+    DfsStack stack;
+    uint8_t depth = size;
+
+    memcpy(stack.path, moves, size);
+    stack.states[depth] = state;
+    stack.phases[depth] = edges_phase_state;
+
+    if (depth >= min_depth && is_original_state(table != NULL ? move_table_state(table, state) : state, original_states))
+    {
+        if (edges_all0 || edge_phase_solved(edges_phase_state))
+            dfs_report(solutions, stack.path, depth);
 
-    if (stack -> size == 1)
+        return;
+    }
+
+    if (depth >= max_depth)
+        return;
+
+    if (kernel != NULL && table == NULL && prune == NULL)
     {
-        stack -> head = NULL;
-        stack -> last = NULL;
+        KernelSearch search = {original_states, edges_all0, min_depth, max_depth};
+
+        memcpy(search.path, moves, size);
+        search.report = dfs_kernel_report;
+        search.data = solutions;
+        kernel -> dfs(&search, state, edges_phase_state, size);
+        return;
     }
-    else
-        stack -> last = stack -> last -> prev;
 
-    stack -> size--;
+    stack.cursors[depth] = 1;
+
+    while (depth >= size)
+    {
+        // a row of moves_map holds up to 18 next moves, ended by an empty move if it is not full
+        const Move current_move = stack.cursors[depth] < 19 ? moves_map[stack.path[depth - 1] * 19 + stack.cursors[depth]] : EMPTY;
+
+        // every next move of this depth is searched
+        if (current_move.transform == NULL)
+        {
+            depth--;
+            continue;
+        }
+
+        stack.cursors[depth]++;
+
+        const uint8_t serial = current_move.serial;
+        const uint64_t new_state = table != NULL ? move_table_next(table, stack.states[depth], serial) :
+                                                   current_move.transform(stack.states[depth]);
+        const uint8_t new_phase = EDGE_PHASE_TABLE[serial][stack.phases[depth]];
+
+        if (prune != NULL && prune -> cut(prune -> data, table != NULL ? move_table_state(table, new_state) : new_state,
+                                          new_phase, serial, max_depth - depth - 1))
+            continue;
+
+        stack.path[depth] = serial;
+
+        if (depth + 1 >= min_depth && is_original_state(table != NULL ? move_table_state(table, new_state) : new_state, original_states))
+        {
+            if (edges_all0 || edge_phase_solved(new_phase))
+                dfs_report(solutions, stack.path, depth + 1);
+
+            continue;
+        }
+
+        if (depth + 1 >= max_depth)
+            continue;
 
-    free(node);
+        depth++;
+        stack.states[depth] = new_state;
+        stack.phases[depth] = new_phase;
+        stack.cursors[depth] = 1;
+    }
 }
 
 /**
- *                    Frees all the memory allocated by a move stack.
+ *                       A helper function to perform DFS algorithm with a pruning automaton.
  *
- * This function traverses the move stack, freeing each node in the stack. It is
- * recommended to call this function after the move stack is no longer needed to
- * prevent memory leaks.
+ * This function works like dfs_iterator, but the moves tried after a path are the
+ * transitions of its automaton state instead of the moves_map row of its last move, so
+ * the sequences that only repeat an earlier one, or that no constraint allows, are never
+ * played. The automaton state of every depth is kept in DfsStack along with the state, and
+ * a path only counts as a solution if its automaton state is accepting.
  *
- * @param stack             The move stack to free.
+ * @param state                 The state of the cube after the first moves.
+ * @param edges_phase_state     The edge phase after the first moves, carried along with EDGE_PHASE_TABLE.
+ * @param context               The automaton state after the first moves.
+ * @param edges_all0            A boolean indicating whether all edge phases are zero.
+ * @param moves                 The serials of the first moves, at least one.
+ * @param size                  How many first moves.
+ * @param automaton             The automaton to step.
+ * @param original_states       An array of original states.
+ * @param min_depth             The minimum depth of the solution.
+ * @param max_depth             The maximum depth of the solution, less than DFS_MAX_DEPTH.
+ * @param solutions             Where the solutions go.
+ * @param table                 The transition table to walk instead of the move functions, or NULL.
+ *                               When given, state is a dense index instead of a packed state.
  */
-void move_list_free(MoveList* stack)
+void dfs_automaton_iterator(uint64_t state, uint8_t edges_phase_state, uint32_t context, bool edges_all0,
+                            const uint8_t* moves, uint8_t size, const MoveAutomaton* automaton, const int* original_states,
+                            uint8_t min_depth, uint8_t max_depth, DfsSolutions* solutions, const MoveTable* table)
 {
-    MoveNode* node = stack -> head;
+    DfsStack stack;
+    uint8_t depth = size;
+
+    memcpy(stack.path, moves, size);
+
+    if (depth >= min_depth && is_original_state(table != NULL ? move_table_state(table, state) : state, original_states))
+    {
+        if ((edges_all0 || edge_phase_solved(edges_phase_state)) && (automaton -> accepting == NULL || automaton -> accepting[context]))
+            dfs_report(solutions, stack.path, depth);
+
+        return;
+    }
+
+    if (depth >= max_depth)
+        return;
+
+    stack.states[depth] = state;
+    stack.phases[depth] = edges_phase_state;
+    stack.contexts[depth] = context;
+    stack.cursors[depth] = 0;
 
-    while (node != NULL)
+    while (depth >= size)
     {
-        MoveNode* next = node -> next;
-        free(node);
-        node = next;
+        const uint32_t transition = automaton -> first[stack.contexts[depth]] + stack.cursors[depth];
+
+        // every transition of this depth is searched
+        if (transition == automaton -> first[stack.contexts[depth] + 1])
+        {
+            depth--;
+            continue;
+        }
+
+        stack.cursors[depth]++;
+
+        const uint8_t serial = automaton -> serials[transition];
+        const uint64_t new_state = table != NULL ? move_table_next(table, stack.states[depth], serial) :
+                                                   automaton -> moves[serial].transform(stack.states[depth]);
+        const uint8_t new_phase = EDGE_PHASE_TABLE[serial][stack.phases[depth]];
+        const uint32_t new_context = automaton -> targets[transition];
+
+        stack.path[depth] = serial;
+
+        if (depth + 1 >= min_depth && is_original_state(table != NULL ? move_table_state(table, new_state) : new_state, original_states))
+        {
+            if ((edges_all0 || edge_phase_solved(new_phase)) && (automaton -> accepting == NULL || automaton -> accepting[new_context]))
+                dfs_report(solutions, stack.path, depth + 1);
+
+            continue;
+        }
+
+        if (depth + 1 >= max_depth)
+            continue;
+
+        depth++;
+        stack.states[depth] = new_state;
+        stack.phases[depth] = new_phase;
+        stack.contexts[depth] = new_context;
+        stack.cursors[depth] = 0;
     }
 }
 
 /**
- *                       Prints all the steps in a move stack to the console.
+ *                       A helper function to perform DFS algorithm with macro moves.
  *
- * This function is for debugging purpose.
+ * This function works like dfs_iterator, but walks the macros that follow the last move
+ * instead of single moves. The macros are stored depth first, so each one applies a
+ * single move to the state of its prefix. Sequences with the same net permutation as an
+ * earlier one are not kept: they are never reported and never extended, and the search
+ * only recurses at the end of the longest macros.
  *
- * @param stack                 The move stack to print.
+ * @param state                 The current state of the cube.
+ * @param edges_phase_state     The edge phase of the current state.
+ * @param edges_all0            A boolean indicating whether all edge phases are zero.
+ * @param path                  The serials of the moves of the current path, room for DFS_MAX_DEPTH + MACRO_MAX_LENGTH.
+ * @param depth                 How many moves the current path holds.
+ * @param context               The last move in the path, or MACRO_START if the path is empty.
+ * @param macros                The macro table to walk.
+ * @param original_states       An array of original states.
+ * @param min_depth             The minimum depth of the solution.
+ * @param max_depth             The maximum depth of the solution.
+ * @param solutions             Where the solutions go.
+ * @param table                 The transition table to walk instead of the move functions, or NULL.
+ *                               When given, state is a dense index instead of a packed state.
  */
-void move_list_print(MoveList* stack)
+void dfs_macro_iterator(uint64_t state, uint8_t edges_phase_state, bool edges_all0,
+                        uint8_t* path, uint8_t depth, uint8_t context, const MacroTable* macros, const int* original_states,
+                        uint8_t min_depth, uint8_t max_depth, DfsSolutions* solutions, const MoveTable* table)
 {
-    char res[1024] = "steps: \0";
-
-    MoveNode* node = stack -> head;
+    uint64_t states[MACRO_MAX_LENGTH + 1] = {state};
+    uint8_t phases[MACRO_MAX_LENGTH + 1] = {edges_phase_state};
+    uint32_t i = 0;
 
-    while (node != NULL)
+    while (i < macros -> size[context])
     {
-        strcat(res, node -> move.symbol);
-        strcat(res, "\t\0");
-        node = node -> next;
-    }
+        const Macro* macro = macros -> macros[context] + i;
+        const uint8_t length = macro -> length;
+        const uint8_t serial = macro -> serials[length - 1];
+        const uint8_t size = depth + length;
+
+        // the macros are stored depth first, the moves before this one are already in place
+        path[size - 1] = serial;
+
+        states[length] = table != NULL ? move_table_next(table, states[length - 1], serial) :
+                                         macros -> moves[serial].transform(states[length - 1]);
+        phases[length] = EDGE_PHASE_TABLE[serial][phases[length - 1]];
 
-    puts(res);
+        if (size >= min_depth &&
+            is_original_state(table != NULL ? move_table_state(table, states[length]) : states[length], original_states))
+        {
+            if (macro -> kept && (edges_all0 || edge_phase_solved(phases[length])))
+                dfs_report(solutions, path, size);
+
+            // a path never goes through a solution
+            i = macro -> next;
+            continue;
+        }
+
+        if (size >= max_depth)
+            i = macro -> next; // no room for the extensions
+        else
+        {
+            if (length == macros -> length)
+                dfs_macro_iterator(states[length], phases[length], edges_all0, path, size, serial,
+                                   macros, original_states, min_depth, max_depth, solutions, table);
+
+            i++;
+        }
+    }
 }
 
 /**
- *                       Checks edge phases is correct.
- *
- * This function takes an initial edge phase and a sequence of moves,
- * and checks if the final edge phase of the sequence of moves is one of the edge phases.
- * If the final edge phase of the sequence of moves is one of the edge phases,
- * the function returns true; otherwise, it returns false.
+ *                       Appends a task to the newest end of a deque.
  *
- * @param phase                 The initial edge phase.
- * @param path                  A sequence of moves to check.
+ * @param deque                 The deque.
+ * @param task                  The task to copy in.
  *
- * @return                      True if the final edge phase is one of the edge phases, false otherwise.
+ * @return                      True if the task is appended, false if out of memory.
  */
-
-bool dfs_check_edge_phase(uint8_t phase, MoveList* path)
+static bool dfs_deque_push(DfsDeque* deque, const DfsTask* task)
 {
-    MoveNode* node = path -> head;
+    pthread_mutex_lock(&deque -> lock);
 
-    while (node != NULL)
+    if (deque -> size == deque -> capacity)
     {
-        uint8_t a = node -> move.serial;
+        const size_t capacity = deque -> capacity == 0 ? 64 : 2 * deque -> capacity;
+        DfsTask* tasks = (DfsTask*)(malloc(capacity * sizeof(DfsTask)));
 
-        switch (a)
+        if (tasks == NULL)
         {
-            case 0: {phase = edge_R_transform(phase); break;}
-            case 1: {phase = edge_L_transform(phase); break;}
-            case 2: {phase = edge_F_transform(phase); break;}
-            case 3: {phase = edge_B_transform(phase); break;}
-            case 4:
-            case 5:
-            case 6: break;
-            case 7: {phase = edge_E_transform(phase); break;}
-            case 8: {phase = edge_EPrime_transform(phase); break;}
-            case 9: {phase = edge_E2_transform(phase); break;}
-            case 10:
-            case 11:
-            case 12: break;
-            case 13: {phase = edge_E_transform(phase); break;}
-            case 14: {phase = edge_EPrime_transform(phase); break;}
-            case 15: {phase = edge_E2_transform(phase); break;}
-            case 16: {phase = edge_EPrime_transform(phase); break;}
-            case 17: {phase = edge_E_transform(phase); break;}
-            case 18: {phase = edge_E2_transform(phase); break;}
-            default: break;
+            pthread_mutex_unlock(&deque -> lock);
+            return false;
         }
 
-        node = node -> next;
+        // unrolls the ring buffer, the oldest task first
+        for (size_t i = 0; i < deque -> size; i++)
+            tasks[i] = deque -> tasks[(deque -> head + i) % deque -> capacity];
+
+        free(deque -> tasks);
+        deque -> tasks = tasks;
+        deque -> head = 0;
+        deque -> capacity = capacity;
     }
 
-    return phase == 3 ||
-            phase == edge_E_transform(3) ||
-            phase == edge_EPrime_transform(3) ||
-            phase == edge_E2_transform(3);
+    deque -> tasks[(deque -> head + deque -> size) % deque -> capacity] = *task;
+    deque -> size++;
+    pthread_mutex_unlock(&deque -> lock);
+    return true;
 }
 
 /**
- *                       A helper function to perform DFS algorithm.
+ *                       Takes a task out of a deque.
  *
- * This function takes the current state of the cube, the current edge phase, a boolean indicating whether
- * all edge phases are zero, the current path of moves, the last move in the path, a 2D array of moves, an
- * array of original states, the minimum depth, the maximum depth, and a pointer to the solution count.
+ * The owner takes the newest task, so it goes on deeper into the subtree it just split.
+ * The other threads steal the oldest one, the largest subtree left.
  *
- * If the current state is the original state, the function checks if the edge phase is correct and if so,
- * prints out the path and increments the solution count. If the current depth is greater than or equal to
- * the maximum depth, the function returns.
+ * @param deque                 The deque.
+ * @param task                  Where to copy the task.
+ * @param oldest                True to take the oldest task, false to take the newest one.
  *
- * Otherwise, the function iterates through all possible moves from the last move, pushes the current move onto
- * the path, and calls itself recursively. After the recursive call, the function pops the current move from
- * the path.
+ * @return                      True if a task is taken, false if the deque is empty.
+ */
+static bool dfs_deque_take(DfsDeque* deque, DfsTask* task, bool oldest)
+{
+    bool taken = false;
+
+    pthread_mutex_lock(&deque -> lock);
+
+    if (deque -> size > 0)
+    {
+        const size_t index = oldest ? deque -> head : deque -> head + deque -> size - 1;
+
+        *task = deque -> tasks[index % deque -> capacity];
+        deque -> size--;
+        taken = true;
+
+        if (oldest)
+            deque -> head = (deque -> head + 1) % deque -> capacity;
+    }
+
+    pthread_mutex_unlock(&deque -> lock);
+    return taken;
+}
+
+/**
+ *                       Adds a task to the deque of a worker.
  *
- * @param state                 The current state of the cube.
- * @param edges_phase_state     The current edge phase.
- * @param edges_all0            A boolean indicating whether all edge phases are zero.
- * @param path                  The current path of moves.
- * @param last_move             The last move in the path.
- * @param moves_map             A 2D array of moves.
- * @param original_states       An array of original states.
- * @param min_depth             The minimum depth of the solution.
- * @param max_depth             The maximum depth of the solution.
- * @param solution_count        A pointer to the solution count.
+ * @param worker                The worker.
+ * @param task                  The task.
  */
-void dfs_iterator(uint64_t state, uint8_t edges_phase_state, bool edges_all0,
-                  MoveList* path, int16_t last_move, const Move* moves_map, const int* original_states,
-                  uint8_t min_depth, uint8_t max_depth, uint16_t* solution_count)
+static void dfs_worker_push(DfsWorker* worker, const DfsTask* task)
 {
-    if (path -> size >= min_depth && is_original_state(state, original_states))
+    // counted first, so the search never looks finished while the task is on its way
+    __atomic_add_fetch(&worker -> pool -> pending, 1, __ATOMIC_ACQ_REL);
+
+    if (!dfs_deque_push(&worker -> deque, task))
     {
-        if (edges_all0 || dfs_check_edge_phase(edges_phase_state, path))
-        {
-            (*solution_count)++;
-            move_list_print(path);
-        }
-    
+        __atomic_store_n(&worker -> pool -> out_of_memory, true, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&worker -> pool -> pending, 1, __ATOMIC_ACQ_REL);
+    }
+}
+
+/**
+ *                       Searches the subtree of a task.
+ *
+ * Paths shorter than DFS_SPLIT_DEPTH are checked like dfs_iterator does, then split into
+ * one task per next move. Longer ones are searched by dfs_iterator, or by
+ * dfs_automaton_iterator when the pool has an automaton.
+ *
+ * @param worker                The worker running the task.
+ * @param task                  The task.
+ */
+static void dfs_worker_run(DfsWorker* worker, const DfsTask* task)
+{
+    const DfsPool* pool = worker -> pool;
+    const uint8_t last_move = task -> path[task -> size - 1];
+    const uint32_t state = pool -> table != NULL ? move_table_state(pool -> table, task -> state) : task -> state;
+
+    if (task -> size >= DFS_SPLIT_DEPTH && pool -> automaton != NULL)
+    {
+        dfs_automaton_iterator(task -> state, task -> phase, task -> context, pool -> edges_all0, task -> path, task -> size,
+                               pool -> automaton, pool -> original_states, pool -> min_depth, pool -> max_depth,
+                               &worker -> solutions, pool -> table);
         return;
     }
 
-    if (path -> size >= max_depth)
+    if (task -> size >= DFS_SPLIT_DEPTH)
+    {
+        dfs_iterator(task -> state, task -> phase, pool -> edges_all0, task -> path, task -> size, pool -> moves_map,
+                     pool -> original_states, pool -> min_depth, pool -> max_depth, &worker -> solutions, pool -> table,
+                     pool -> kernel, NULL);
         return;
+    }
 
-    int8_t index = 1;
+    if (task -> size >= pool -> min_depth && is_original_state(state, pool -> original_states))
+    {
+        // with constraints, only the accepting states of the automaton end a solution
+        if ((pool -> edges_all0 || edge_phase_solved(task -> phase)) &&
+            (pool -> automaton == NULL || pool -> automaton -> accepting == NULL || pool -> automaton -> accepting[task -> context]))
+            dfs_report(&worker -> solutions, task -> path, task -> size);
 
-    while (true)
+        return;
+    }
+
+    if (task -> size >= pool -> max_depth)
+        return;
+
+    if (pool -> automaton != NULL)
+    {
+        const MoveAutomaton* automaton = pool -> automaton;
+
+        for (uint32_t t = automaton -> first[task -> context]; t < automaton -> first[task -> context + 1]; t++)
+        {
+            const uint8_t serial = automaton -> serials[t];
+            DfsTask child = *task;
+
+            child.state = pool -> table != NULL ? move_table_next(pool -> table, task -> state, serial) :
+                                                  automaton -> moves[serial].transform(task -> state);
+            child.phase = EDGE_PHASE_TABLE[serial][task -> phase];
+            child.context = automaton -> targets[t];
+            child.path[child.size++] = serial;
+            dfs_worker_push(worker, &child);
+        }
+
+        return;
+    }
+
+    for (uint8_t index = 1; index < 19; index++)
     {
-        const Move current_move = moves_map[last_move * 19 + index];
+        const Move current_move = pool -> moves_map[last_move * 19 + index];
 
         if (current_move.transform == NULL)
             break;
 
-        move_list_push(path, current_move);
-        dfs_iterator(current_move.transform(state), edges_phase_state, edges_all0,
-                    path, current_move.serial, moves_map, original_states, min_depth, max_depth, solution_count);
-        move_list_pop(path);
+        DfsTask child = *task;
 
-        index++;
+        child.state = pool -> table != NULL ? move_table_next(pool -> table, task -> state, current_move.serial) :
+                                              current_move.transform(task -> state);
+        child.phase = EDGE_PHASE_TABLE[current_move.serial][task -> phase];
+        child.path[child.size++] = current_move.serial;
+        dfs_worker_push(worker, &child);
     }
 }
 
+/**
+ *                       Pins the calling thread to a CPU.
+ *
+ * @param cpu                   The CPU.
+ */
+static void dfs_pin(int cpu)
+{
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) != 0)
+        printf("Failed to pin a thread to CPU %d\n", cpu);
+}
+
+/**
+ *                       Runs tasks until every task of every worker is done.
+ *
+ * @param argument              The DfsWorker.
+ *
+ * @return                      NULL.
+ */
+static void* dfs_worker_main(void* argument)
+{
+    DfsWorker* worker = (DfsWorker*)(argument);
+    DfsPool* pool = worker -> pool;
+    DfsTask task;
+
+    if (pool -> affinity != NULL)
+        dfs_pin(pool -> affinity[worker -> id % pool -> affinity_size]);
+
+    while (true)
+    {
+        bool found = dfs_deque_take(&worker -> deque, &task, false);
+
+        for (uint16_t i = 1; !found && i < pool -> size; i++)
+        {
+            found = dfs_deque_take(&pool -> workers[(worker -> id + i) % pool -> size].deque, &task, true);
+            worker -> steals += found;
+        }
+
+        if (found)
+        {
+            dfs_worker_run(worker, &task);
+            __atomic_sub_fetch(&pool -> pending, 1, __ATOMIC_ACQ_REL);
+            continue;
+        }
+
+        if (__atomic_load_n(&pool -> pending, __ATOMIC_ACQUIRE) == 0)
+            break;
+
+        sched_yield();
+    }
+
+    return NULL;
+}
+
 /**
  *                       Solves a cube using DFS algorithm.
  *
@@ -238,6 +628,12 @@ void dfs_iterator(uint64_t state, uint8_t edges_phase_state, bool edges_all0,
  * and solves a cube using DFS algorithm. If the cube is solvable, print all solutions by
  * using DFS algorithm. If the cube is not solvable, print nothing.
  *
+ * With more than one thread, the paths shorter than DFS_SPLIT_DEPTH are tasks. Every thread
+ * keeps its tasks in its own deque, takes the newest one, and steals the oldest one of
+ * another thread when it runs out, so unbalanced subtrees keep every thread busy. The
+ * solutions are kept per thread and printed DFS_BUFFER_SIZE bytes at a time, so their
+ * order is not the one of a single thread.
+ *
  * @param moves                 An array of moves to use for solving the cube.
  * @param moves_map             A 2D array of moves to use for solving the cube.
  * @param original_states       An array of original states to check against.
@@ -245,35 +641,154 @@ void dfs_iterator(uint64_t state, uint8_t edges_phase_state, bool edges_all0,
  * @param edges_phase_state     The initial edge phase of the cube.
  * @param min_depth             The minimum depth of the solution.
  * @param max_depth             The maximum depth of the solution.
+ * @param table                 The transition table to walk instead of the move functions, or NULL.
+ * @param macros                The macro table to step by, or NULL (the macro search runs on one thread).
+ * @param automaton             The pruning automaton to step instead of moves_map, or NULL (ignored with macros).
+ * @param kernel                The generated kernel of moves_map, or NULL (ignored with a table, macros or an automaton).
+ * @param threads               How many threads search, 0 for one per CPU.
+ * @param affinity              The CPU of every thread (thread i runs on affinity[i % affinity_size]), or NULL.
+ * @param affinity_size         How many CPUs affinity holds.
  */
 void cube_dfs_solver(const Move* moves, const Move* moves_map, const int* original_states,
-                     uint32_t state, uint8_t edges_phase_state, uint8_t min_depth, uint8_t max_depth)
+                     uint32_t state, uint8_t edges_phase_state, uint8_t min_depth, uint8_t max_depth,
+                     const MoveTable* table, const MacroTable* macros, const MoveAutomaton* automaton, const SearchKernel* kernel,
+                     uint16_t threads, const int* affinity, uint8_t affinity_size)
 {
     const uint8_t moves_size = 19;
     const Move ALL_MOVES[19] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2};
     const bool edges_all0 = (state & 0xffu) == 0;
 
-    uint16_t solution_count = 0;
+    DfsSolutions solutions = {0, false, NULL, 0, NULL};
     uint64_t current_time = get_current_time();
 
     puts("start searching");
+    edge_phase_table_init();
+
+    if (table != NULL)
+        state = move_table_index(table, state);
+
+    if (threads == 0)
+        threads = sysconf(_SC_NPROCESSORS_ONLN) > 0 ? sysconf(_SC_NPROCESSORS_ONLN) : 1;
+
+    if (max_depth >= DFS_MAX_DEPTH)
+        max_depth = DFS_MAX_DEPTH - 1;
+
+    if (macros != NULL)
+    {
+        uint8_t path[DFS_MAX_DEPTH + MACRO_MAX_LENGTH];
+
+        dfs_macro_iterator(state, edges_phase_state, edges_all0,
+                           path, 0, MACRO_START, macros, original_states, min_depth, max_depth, &solutions, table);
+    }
+    else if (threads > 1)
+    {
+        DfsPool pool = {moves_map, original_states, table, kernel, automaton, edges_all0, min_depth, max_depth, threads,
+                        affinity_size > 0 ? affinity : NULL, affinity_size};
+        pthread_t* ids = (pthread_t*)(malloc(threads * sizeof(pthread_t)));
+        uint32_t steals = 0;
+
+        pool.workers = (DfsWorker*)(calloc(threads, sizeof(DfsWorker)));
+        pthread_mutex_init(&pool.print_lock, NULL);
+
+        for (uint16_t i = 0; pool.workers != NULL && i < threads; i++)
+        {
+            pool.workers[i] = (DfsWorker){&pool, i, {NULL, 0, 0, 0}, {0, true, (char*)(malloc(DFS_BUFFER_SIZE)), 0, &pool.print_lock}, 0};
+            pthread_mutex_init(&pool.workers[i].deque.lock, NULL);
+            pool.out_of_memory |= pool.workers[i].solutions.text == NULL;
+        }
+
+        if (ids == NULL || pool.workers == NULL || pool.out_of_memory)
+            printf("Failed to start %d threads: out of memory\n", threads);
+        else
+        {
+            // the first moves, dealt to the workers in turn
+            for (uint8_t i = 0, worker = 0; i < moves_size && automaton == NULL; i++)
+            {
+                if (moves_map[i * moves_size + 1].transform == NULL)
+                    continue;
+
+                DfsTask task = {table != NULL ? move_table_next(table, state, i) : ALL_MOVES[i].transform(state),
+                                EDGE_PHASE_TABLE[i][edges_phase_state], 1, {i}};
+
+                dfs_worker_push(pool.workers + worker, &task);
+                worker = (worker + 1) % threads;
+            }
+
+            for (uint32_t t = automaton != NULL ? automaton -> first[AUTOMATON_START] : 0, worker = 0;
+                 automaton != NULL && t < automaton -> first[AUTOMATON_START + 1]; t++)
+            {
+                const uint8_t serial = automaton -> serials[t];
+                DfsTask task = {table != NULL ? move_table_next(table, state, serial) : ALL_MOVES[serial].transform(state),
+                                EDGE_PHASE_TABLE[serial][edges_phase_state], 1, {serial}, automaton -> targets[t]};
+
+                dfs_worker_push(pool.workers + worker, &task);
+                worker = (worker + 1) % threads;
+            }
+
+            // the calling thread is worker 0, it steals the tasks of the workers no thread could be started for
+            uint16_t started = 1;
+
+            while (started < threads && pthread_create(ids + started, NULL, dfs_worker_main, pool.workers + started) == 0)
+                started++;
+
+            if (started < threads)
+                printf("Failed to start %d of %d threads, their tasks are stolen\n", threads - started, threads);
+
+            dfs_worker_main(pool.workers);
+
+            for (uint16_t i = 1; i < started; i++)
+                pthread_join(ids[i], NULL);
+
+            if (pool.out_of_memory)
+                printf("Failed to split the search: out of memory, some solutions are missing\n");
+        }
+
+        for (uint16_t i = 0; pool.workers != NULL && i < threads; i++)
+        {
+            DfsWorker* worker = pool.workers + i;
+
+            if (worker -> solutions.text != NULL)
+                fwrite(worker -> solutions.text, 1, worker -> solutions.size, stdout);
+
+            solutions.count += worker -> solutions.count;
+            steals += worker -> steals;
+            free(worker -> solutions.text);
+            free(worker -> deque.tasks);
+            pthread_mutex_destroy(&worker -> deque.lock);
+        }
+
+        fflush(stdout);
+        printf("threads: %d, stolen tasks: %u\n", threads, steals);
+        pthread_mutex_destroy(&pool.print_lock);
+        free(pool.workers);
+        free(ids);
+    }
+    else if (automaton != NULL)
+    {
+        for (uint32_t t = automaton -> first[AUTOMATON_START]; t < automaton -> first[AUTOMATON_START + 1]; t++)
+        {
+            const uint8_t serial = automaton -> serials[t];
+            const uint64_t new_state = table != NULL ? move_table_next(table, state, serial) : ALL_MOVES[serial].transform(state);
+
+            dfs_automaton_iterator(new_state, EDGE_PHASE_TABLE[serial][edges_phase_state], automaton -> targets[t], edges_all0,
+                                   &serial, 1, automaton, original_states, min_depth, max_depth, &solutions, table);
+        }
+    }
     
-    for (uint8_t i = 0; i < moves_size; i++)
+    for (uint8_t i = 0; i < moves_size && macros == NULL && automaton == NULL && threads <= 1; i++)
     {
         const Move second_move = moves_map[i * moves_size + 1];
 
         if (second_move.transform != NULL)
         {
-            MoveList path;
             const Move first_move = ALL_MOVES[i];
-            move_list_push_head(&path, first_move);
-            dfs_iterator(first_move.transform(state), edges_phase_state, edges_all0,
-                         &path, first_move.serial, moves_map, original_states, min_depth, max_depth, &solution_count);
-            
-            
-            free(path.head);
+            const uint32_t new_state = table != NULL ? move_table_next(table, state, first_move.serial) :
+                                                       first_move.transform(state);
+
+            dfs_iterator(new_state, EDGE_PHASE_TABLE[first_move.serial][edges_phase_state], edges_all0,
+                         &i, 1, moves_map, original_states, min_depth, max_depth, &solutions, table, kernel, NULL);
         }
     }
 
-    printf("search end in %lf (s), find total %d solutions: ", (get_current_time() - current_time) / 1000.0, solution_count);
-}
\ No newline at end of file
+    printf("search end in %lf (s), find total %u solutions: ", (get_current_time() - current_time) / 1000.0, solutions.count);
+}
@@ -0,0 +1,617 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "distance_table.h"
+#include "cube_rank.h"
+#include "utils.h"
+
+/**
+ *                       Stores the distance of a ranked state after a class of contexts.
+ *
+ * @param table                 The table to write to.
+ * @param index                 The rank of the state.
+ * @param class                 The class of the context.
+ * @param distance              The distance, 4 bits.
+ */
+static void distance_table_set(DistanceTable* table, uint32_t index, uint8_t class, uint8_t distance)
+{
+    const size_t position = (size_t)(class) * table -> size + index;
+    uint8_t* byte = table -> distances + position / 2;
+
+    *byte = position & 1 ? (*byte & 0x0f) | distance << 4 : (*byte & 0xf0) | distance;
+}
+
+/**
+ *                       Looks up the distance of a ranked state after a class of contexts.
+ *
+ * @param table                 The table to search in.
+ * @param index                 The rank of the state.
+ * @param class                 The class of the context.
+ *
+ * @return                      The distance, or DISTANCE_UNKNOWN.
+ */
+static uint8_t distance_table_class_get(const DistanceTable* table, uint32_t index, uint8_t class)
+{
+    const size_t position = (size_t)(class) * table -> size + index;
+
+    // the builder threads may be claiming the other half of the byte
+    return __atomic_load_n(table -> distances + position / 2, __ATOMIC_RELAXED) >> (4 * (position & 1)) & 0xf;
+}
+
+/**
+ *                       Ranks a packed state and its edge flip the way the table indexes them.
+ *
+ * @param table                 The table.
+ * @param state                 The packed state.
+ * @param flip                  The edge flip, 0 or 1.
+ *
+ * @return                      The corner rank, or the state rank and the flip.
+ */
+static uint32_t distance_table_rank(const DistanceTable* table, uint32_t state, uint8_t flip)
+{
+    if (table -> corners_only)
+        return corners_rank(state);
+
+    return (table -> edges_only ? edges_rank(state) : cube_state_rank(state)) << 1 | flip;
+}
+
+/**
+ *                       Builds the packed state of an index of the table, without the edge flip.
+ *
+ * @param table                 The table.
+ * @param index                 The index, as built by distance_table_rank.
+ *
+ * @return                      The packed state, with the pieces the table ignores set to zero.
+ */
+static uint32_t distance_table_unrank(const DistanceTable* table, uint32_t index)
+{
+    if (table -> corners_only)
+        return corners_unrank(index);
+
+    return table -> edges_only ? edges_unrank(index >> 1) : cube_state_unrank(index >> 1);
+}
+
+typedef struct distance_sweep
+{
+    DistanceTable* table;
+    Move moves[19]; // the moves by serial
+    uint32_t contexts[19]; // contexts[m]: the classes that allow move m next
+    uint8_t inverse[19]; // the move undoing every move
+    uint8_t flips[19]; // 1 if the move changes the edge flip, it does not depend on the state
+    uint64_t* frontier; // bit i is set if state i has a class at the current depth
+    uint64_t* next; // the same for depth + 1, filled by the workers
+    uint64_t* visited; // bit i is set once state i has a class with a known distance
+    uint32_t words; // the length of the bitmaps
+    uint8_t depth; // the current depth
+} DistanceSweep;
+
+typedef struct distance_worker
+{
+    DistanceSweep* sweep;
+    uint32_t begin; // the first bitmap word of the worker
+    uint32_t end; // past the last bitmap word of the worker
+    uint32_t found; // how many entries the worker set at depth + 1
+    uint32_t visited; // how many states the worker visited for the first time
+} DistanceWorker;
+
+/**
+ *                       Sets an unknown distance, safe against other workers.
+ *
+ * @param table                 The table to write to.
+ * @param index                 The rank of the state.
+ * @param class                 The class of the context.
+ * @param distance              The distance, 4 bits.
+ *
+ * @return                      True if the distance was unknown and is now set.
+ */
+static bool distance_table_claim(DistanceTable* table, uint32_t index, uint8_t class, uint8_t distance)
+{
+    const size_t position = (size_t)(class) * table -> size + index;
+    const uint8_t shift = 4 * (position & 1);
+    uint8_t* byte = table -> distances + position / 2;
+    uint8_t expected = __atomic_load_n(byte, __ATOMIC_RELAXED);
+
+    // the other half of the byte may be claimed at the same time, retry until this half is known
+    while ((expected >> shift & 0xf) == DISTANCE_UNKNOWN)
+    {
+        const uint8_t desired = (expected & ~(0xf << shift)) | distance << shift;
+
+        if (__atomic_compare_exchange_n(byte, &expected, desired, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ *                       Marks a state in the next frontier.
+ *
+ * @param worker                The worker.
+ * @param index                 The rank of the state.
+ */
+static void distance_worker_reach(DistanceWorker* worker, uint32_t index)
+{
+    const uint64_t bit = 1ull << (index & 63);
+
+    __atomic_fetch_or(worker -> sweep -> next + index / 64, bit, __ATOMIC_RELAXED);
+
+    if (!(__atomic_fetch_or(worker -> sweep -> visited + index / 64, bit, __ATOMIC_RELAXED) & bit))
+        worker -> visited++;
+}
+
+/**
+ *                       Expands the frontier states of a worker top-down.
+ *
+ * Every state at the current depth after move m makes its predecessor (m undone) one
+ * move further after every context allowing m, unless that distance is already known.
+ *
+ * @param argument              The DistanceWorker.
+ *
+ * @return                      NULL.
+ */
+static void* distance_top_down(void* argument)
+{
+    DistanceWorker* worker = (DistanceWorker*)(argument);
+    const DistanceSweep* sweep = worker -> sweep;
+    DistanceTable* table = sweep -> table;
+
+    for (uint32_t word = worker -> begin; word < worker -> end; word++)
+    {
+        uint64_t bits = sweep -> frontier[word];
+
+        while (bits != 0)
+        {
+            const uint32_t index = word * 64 + __builtin_ctzll(bits);
+            uint32_t frontier = 0;
+
+            bits &= bits - 1;
+
+            for (uint8_t class = 0; class < table -> classes; class++)
+                frontier |= (uint32_t)(distance_table_class_get(table, index, class) == sweep -> depth) << class;
+
+            const uint32_t state = distance_table_unrank(table, index);
+            const uint8_t flip = table -> corners_only ? 0 : index & 1;
+
+            for (uint8_t m = 0; m < 19; m++)
+            {
+                if (sweep -> contexts[m] == 0 || !(frontier >> table -> class_of[m] & 1))
+                    continue;
+
+                const uint32_t previous = distance_table_rank(table, sweep -> moves[sweep -> inverse[m]].transform(state),
+                                                              flip ^ sweep -> flips[m]);
+                bool reached = false;
+
+                for (uint8_t class = 0; class < table -> classes; class++)
+                {
+                    if (sweep -> contexts[m] >> class & 1 && distance_table_claim(table, previous, class, sweep -> depth + 1))
+                    {
+                        worker -> found++;
+                        reached = true;
+                    }
+                }
+
+                if (reached)
+                    distance_worker_reach(worker, previous);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ *                       Settles the unknown states of a worker bottom-up.
+ *
+ * An unknown state is one move further than the current depth after a context if any
+ * move the context allows leads to a frontier state at the current depth. Every worker
+ * only writes its own states, and stops looking at a state once all its classes are set.
+ *
+ * @param argument              The DistanceWorker.
+ *
+ * @return                      NULL.
+ */
+static void* distance_bottom_up(void* argument)
+{
+    DistanceWorker* worker = (DistanceWorker*)(argument);
+    const DistanceSweep* sweep = worker -> sweep;
+    DistanceTable* table = sweep -> table;
+    const uint32_t end = worker -> end * 64 < table -> size ? worker -> end * 64 : table -> size;
+
+    for (uint32_t index = worker -> begin * 64; index < end; index++)
+    {
+        uint32_t unknown = 0;
+
+        for (uint8_t class = 0; class < table -> classes; class++)
+            unknown |= (uint32_t)(distance_table_class_get(table, index, class) == DISTANCE_UNKNOWN) << class;
+
+        if (unknown == 0)
+            continue;
+
+        const uint32_t state = distance_table_unrank(table, index);
+        const uint8_t flip = table -> corners_only ? 0 : index & 1;
+        bool reached = false;
+
+        for (uint8_t m = 0; m < 19 && unknown != 0; m++)
+        {
+            if (!(sweep -> contexts[m] & unknown))
+                continue;
+
+            const uint32_t next = distance_table_rank(table, sweep -> moves[m].transform(state), flip ^ sweep -> flips[m]);
+
+            if (!(sweep -> frontier[next / 64] >> (next & 63) & 1) ||
+                distance_table_class_get(table, next, table -> class_of[m]) != sweep -> depth)
+                continue;
+
+            for (uint8_t class = 0; class < table -> classes; class++)
+            {
+                if ((sweep -> contexts[m] & unknown) >> class & 1 && distance_table_claim(table, index, class, sweep -> depth + 1))
+                    worker -> found++;
+            }
+
+            unknown &= ~sweep -> contexts[m];
+            reached = true;
+        }
+
+        if (reached)
+            distance_worker_reach(worker, index);
+    }
+
+    return NULL;
+}
+
+/**
+ *                       Builds the distance of every state for a moves map.
+ *
+ * This function runs a breadth-first sweep backwards from the original states over every
+ * ranked state and stores the exact number of moves to solve it with moves_map. Only the
+ * corners are ranked when the original states ignore the edges, and only the edges (and
+ * their flip) when the original states set the corners to zero. The moves allowed depend
+ * on the last move played, so the distance is stored for every class of contexts with the
+ * same next moves.
+ *
+ * The sweep is level-synchronous over a bitmap of the frontier states, split between
+ * threads. Small frontiers are expanded top-down, from every frontier state to its
+ * predecessors. Once the frontier holds more than 1 / DISTANCE_BOTTOM_UP of the states not
+ * visited yet, every unknown state looks for a neighbour in the frontier instead. The
+ * workers never lock: distances are claimed with atomic compare-and-swap on their byte.
+ *
+ * @param table                 The table to build.
+ * @param moves_map             A 2D array of moves (19 x 19), as given to the solvers.
+ * @param original_states       The 8 original states, the edges are ignored if they are zero.
+ * @param threads               How many threads sweep the states, 0 for one per CPU.
+ *
+ * @return                      True if the table is built, false if out of memory.
+ */
+bool distance_table_create(DistanceTable* table, const Move* moves_map, const int* original_states, uint16_t threads)
+{
+    const uint8_t moves_size = 19;
+    const Move ALL_MOVES[19] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2};
+    uint32_t* successors = table -> successors;
+    DistanceSweep sweep = {.table = table};
+
+    memset(table, 0, sizeof(DistanceTable));
+    table -> corners_only = (original_states[0] & 0xff) == 0;
+    table -> edges_only = (original_states[0] & 0xffffff00) == 0;
+    table -> size = table -> corners_only ? CUBE_CORNERS_SIZE : table -> edges_only ? 2 * CUBE_EDGES_SIZE : CUBE_PHASE_STATES_SIZE;
+    table -> moves_map = moves_map;
+
+    if (threads == 0)
+        threads = sysconf(_SC_NPROCESSORS_ONLN) > 0 ? sysconf(_SC_NPROCESSORS_ONLN) : 1;
+
+    table -> threads = threads;
+
+    // the same first moves as the solvers: every move whose row allows a second move
+    for (uint8_t i = 0; i < moves_size; i++)
+    {
+        for (uint8_t j = 1; j < moves_size && moves_map[i * moves_size + j].transform != NULL; j++)
+            successors[i] |= 1u << moves_map[i * moves_size + j].serial;
+
+        if (successors[i] != 0)
+            successors[DISTANCE_START] |= 1u << i;
+    }
+
+    for (uint8_t i = 0; i < DISTANCE_CONTEXTS; i++)
+    {
+        table -> class_of[i] = table -> classes;
+
+        for (uint8_t j = 0; j < i; j++)
+        {
+            if (successors[j] == successors[i])
+            {
+                table -> class_of[i] = table -> class_of[j];
+                break;
+            }
+        }
+
+        if (table -> class_of[i] == table -> classes)
+            table -> classes++;
+    }
+
+    for (uint8_t i = 0; i < DISTANCE_CONTEXTS; i++)
+    {
+        for (uint8_t m = 0; m < moves_size; m++)
+        {
+            if (successors[i] >> m & 1)
+                sweep.contexts[m] |= 1u << table -> class_of[i];
+        }
+    }
+
+    for (uint8_t m = 0; m < moves_size; m++)
+    {
+        const uint32_t moved = ALL_MOVES[m].transform(87652123);
+
+        sweep.moves[m] = ALL_MOVES[m];
+
+        for (uint8_t n = 0; n < moves_size; n++)
+        {
+            if (ALL_MOVES[n].transform(moved) == 87652123)
+            {
+                sweep.inverse[m] = n;
+                break;
+            }
+        }
+
+        sweep.flips[m] = edges_flip(moved, edge_transform(3, m));
+    }
+
+    const size_t bytes = ((size_t)(table -> classes) * table -> size + 1) / 2;
+
+    sweep.words = (table -> size + 63) / 64;
+    table -> distances = (uint8_t*)(malloc(bytes));
+    sweep.frontier = (uint64_t*)(calloc(sweep.words, sizeof(uint64_t)));
+    sweep.next = (uint64_t*)(calloc(sweep.words, sizeof(uint64_t)));
+    sweep.visited = (uint64_t*)(calloc(sweep.words, sizeof(uint64_t)));
+
+    DistanceWorker* workers = (DistanceWorker*)(malloc(threads * sizeof(DistanceWorker)));
+    pthread_t* ids = (pthread_t*)(malloc(threads * sizeof(pthread_t)));
+
+    if (table -> distances == NULL || sweep.frontier == NULL || sweep.next == NULL || sweep.visited == NULL ||
+        workers == NULL || ids == NULL)
+    {
+        free(sweep.frontier);
+        free(sweep.next);
+        free(sweep.visited);
+        free(workers);
+        free(ids);
+        distance_table_free(table);
+        return false;
+    }
+
+    memset(table -> distances, 0xff, bytes);
+
+    // distance 0: the original states after any context, with the edge flip of their solved phases
+    uint32_t frontier_size = 0;
+    uint32_t visited_size = 0;
+
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        const uint32_t state = original_states[i];
+        const uint8_t flip = table -> corners_only || edge_phase_solved(edges_phase(state, 0)) ? 0 : 1;
+        const uint32_t index = distance_table_rank(table, state, flip);
+
+        for (uint8_t class = 0; class < table -> classes; class++)
+            distance_table_set(table, index, class, 0);
+
+        if (!(sweep.frontier[index / 64] >> (index & 63) & 1))
+            frontier_size++;
+
+        sweep.frontier[index / 64] |= 1ull << (index & 63);
+        sweep.visited[index / 64] |= 1ull << (index & 63);
+    }
+
+    visited_size = frontier_size;
+
+    for (sweep.depth = 0; sweep.depth < DISTANCE_MAX; sweep.depth++)
+    {
+        const bool bottom_up = (uint64_t)(frontier_size) * DISTANCE_BOTTOM_UP > table -> size - visited_size;
+        uint32_t found = 0;
+        uint16_t started = 0;
+
+        for (uint16_t i = 0; i < threads; i++)
+            workers[i] = (DistanceWorker){&sweep, (uint64_t)(sweep.words) * i / threads, (uint64_t)(sweep.words) * (i + 1) / threads, 0, 0};
+
+        while (started + 1 < threads && pthread_create(ids + started, NULL, bottom_up ? distance_bottom_up : distance_top_down, workers + started) == 0)
+            started++;
+
+        // the calling thread is the last worker, and every worker no thread could be started for
+        for (uint16_t i = started; i < threads; i++)
+            (bottom_up ? distance_bottom_up : distance_top_down)(workers + i);
+
+        for (uint16_t i = 0; i < threads; i++)
+        {
+            if (i < started)
+                pthread_join(ids[i], NULL);
+
+            found += workers[i].found;
+            visited_size += workers[i].visited;
+        }
+
+        table -> bottom_up[sweep.depth] = bottom_up;
+
+        if (found == 0)
+            break;
+
+        table -> depth = sweep.depth + 1;
+
+        // the next frontier becomes the current one
+        uint64_t* frontier = sweep.frontier;
+
+        sweep.frontier = sweep.next;
+        sweep.next = frontier;
+        memset(sweep.next, 0, sweep.words * sizeof(uint64_t));
+        frontier_size = 0;
+
+        for (uint32_t i = 0; i < sweep.words; i++)
+            frontier_size += __builtin_popcountll(sweep.frontier[i]);
+    }
+
+    for (uint32_t index = 0; index < table -> size; index++)
+    {
+        const uint8_t distance = distance_table_class_get(table, index, table -> class_of[DISTANCE_START]);
+
+        if (distance != DISTANCE_UNKNOWN)
+            table -> count[distance]++;
+    }
+
+    free(sweep.frontier);
+    free(sweep.next);
+    free(sweep.visited);
+    free(workers);
+    free(ids);
+    return true;
+}
+
+/**
+ *                       Frees all the memory allocated by a distance table.
+ *
+ * @param table                 The table to free.
+ */
+void distance_table_free(DistanceTable* table)
+{
+    free(table -> distances);
+    table -> distances = NULL;
+}
+
+/**
+ *                       Looks up the distance of a ranked state after a context.
+ *
+ * @param table                 The table to search in.
+ * @param index                 The index of the state, as built by distance_table_index.
+ * @param context               The last move played, or DISTANCE_START.
+ *
+ * @return                      The number of moves to solve the state, or DISTANCE_UNKNOWN.
+ */
+uint8_t distance_table_get(const DistanceTable* table, uint32_t index, uint8_t context)
+{
+    return distance_table_class_get(table, index, table -> class_of[context]);
+}
+
+/**
+ *                       Ranks a cube the way a distance table indexes it.
+ *
+ * The pieces the table ignores are left out, so any packed state with every corner (and
+ * every edge, unless the table ranks corners only) can be looked up, the table then gives
+ * a lower bound of the moves to solve it.
+ *
+ * @param table                 The table.
+ * @param state                 The packed state.
+ * @param phase                 The edge phase, as built by edges_phase_convert (ignored if corners only).
+ *
+ * @return                      The index of the state in the table.
+ */
+uint32_t distance_table_index(const DistanceTable* table, uint32_t state, uint8_t phase)
+{
+    return distance_table_rank(table, state, table -> corners_only ? 0 : edges_flip(state, phase));
+}
+
+/**
+ *                       Looks up the optimal solution length of a cube.
+ *
+ * @param table                 The table to search in.
+ * @param state                 The packed state.
+ * @param phase                 The edge phase, as built by edges_phase_convert (ignored if corners only).
+ *
+ * @return                      The number of moves to solve the cube, or DISTANCE_UNKNOWN.
+ */
+uint8_t cube_distance(const DistanceTable* table, uint32_t state, uint8_t phase)
+{
+    if (!cube_state_valid(state) || table -> corners_only != ((state & 0xff) == 0))
+        return DISTANCE_UNKNOWN;
+
+    return distance_table_get(table, distance_table_index(table, state, phase), DISTANCE_START);
+}
+
+/**
+ *                       A helper function to descend along decreasing distances.
+ *
+ * @param table                 The distance table.
+ * @param state                 The current state of the cube.
+ * @param phase                 The edge phase of the current state.
+ * @param context               The last move played, or DISTANCE_START.
+ * @param distance              The distance of the current state after the context.
+ * @param path                  The serials of the moves played.
+ * @param size                  How many moves are played.
+ * @param solution_count        A pointer to the solution count.
+ */
+static void distance_descend(const DistanceTable* table, uint32_t state, uint8_t phase, uint8_t context,
+                             uint8_t distance, uint8_t* path, uint8_t size, uint16_t* solution_count)
+{
+    const Move ALL_MOVES[19] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2};
+
+    if (distance == 0)
+    {
+        char string[128] = "steps: \0";
+
+        for (uint8_t i = 0; i < size; i++)
+        {
+            strcat(string, ALL_MOVES[path[i]].symbol);
+            strcat(string, "\t");
+        }
+
+        puts(string);
+        (*solution_count)++;
+        return;
+    }
+
+    for (uint8_t i = 0; i < 19; i++)
+    {
+        // in moves_map order: the first moves are the heads of the rows, the next moves follow the last one in its row
+        const Move move = context == DISTANCE_START ? table -> moves_map[i * 19] :
+                          i + 1 < 19 ? table -> moves_map[context * 19 + i + 1] : EMPTY;
+
+        if (move.transform == NULL || !(table -> successors[context] >> move.serial & 1))
+            continue;
+
+        const uint32_t new_state = ALL_MOVES[move.serial].transform(state);
+        const uint8_t new_phase = EDGE_PHASE_TABLE[move.serial][phase];
+        const uint32_t index = distance_table_index(table, new_state, new_phase);
+
+        if (distance_table_get(table, index, move.serial) != distance - 1)
+            continue;
+
+        path[size] = move.serial;
+        distance_descend(table, new_state, new_phase, move.serial, distance - 1, path, size + 1, solution_count);
+    }
+}
+
+/**
+ *                       Prints every optimal solution of a cube.
+ *
+ * This function descends from the cube along moves that decrease the distance by one,
+ * so every branch ends in a solution of the optimal length and nothing else is expanded.
+ * Nothing is printed if the optimal length is not within min_depth and max_depth.
+ *
+ * @param table                 The distance table of the moves map.
+ * @param state                 The initial state of the cube.
+ * @param edges_phase_state     The initial edge phase of the cube.
+ * @param min_depth             The minimum depth of the solution.
+ * @param max_depth             The maximum depth of the solution.
+ */
+void cube_distance_solver(const DistanceTable* table, uint32_t state, uint8_t edges_phase_state,
+                          uint8_t min_depth, uint8_t max_depth)
+{
+    uint8_t path[DISTANCE_MAX];
+    uint16_t solution_count = 0;
+    uint64_t current_time = get_current_time();
+
+    puts("start searching");
+    edge_phase_table_init();
+
+    const uint8_t distance = cube_distance(table, state, edges_phase_state);
+
+    if (distance == DISTANCE_UNKNOWN)
+        printf("distance: unknown (not solvable with the moves map in %d moves)\n", DISTANCE_MAX);
+    else
+    {
+        printf("distance: %d\n", distance);
+
+        if (distance >= min_depth && distance <= max_depth)
+            distance_descend(table, state, edges_phase_state, DISTANCE_START, distance, path, 0, &solution_count);
+    }
+
+    printf("search end in %lf (s), find total %d solutions: ", (get_current_time() - current_time) / 1000.0, solution_count);
+}
@@ -0,0 +1,190 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "goal_cache.h"
+
+/**
+ *                       Hashes what the goal side of a search depends on.
+ *
+ * The backward paths only depend on the moves allowed after every move and on the
+ * original states, so two queries with the same signature can share them.
+ *
+ * @param successors            Bit m of successors[i] is set if move m may follow move i (or the start, i = 19).
+ * @param original_states       The 8 original states.
+ *
+ * @return                      The FNV-1a hash of both.
+ */
+uint64_t goal_cache_signature(const uint32_t* successors, const int* original_states)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    for (uint8_t i = 0; i < 20 + 8; i++)
+    {
+        const uint32_t word = i < 20 ? successors[i] : (uint32_t)(original_states[i - 20]);
+
+        for (uint8_t j = 0; j < 4; j++)
+        {
+            hash ^= word >> (8 * j) & 0xff;
+            hash *= 0x100000001b3ull;
+        }
+    }
+
+    return hash;
+}
+
+/**
+ *                       Reads the header of a goal cache file and checks it.
+ *
+ * @param file                  The file, at its start.
+ * @param signature             The signature the levels must have been built for.
+ * @param header                Where to store the header.
+ *
+ * @return                      True if the header is read and matches the signature and this version.
+ */
+static bool goal_cache_header_read(FILE* file, uint64_t signature, GoalCacheHeader* header)
+{
+    return fread(header, sizeof(GoalCacheHeader), 1, file) == 1 && header -> magic == GOAL_CACHE_MAGIC &&
+           header -> version == GOAL_CACHE_VERSION && header -> signature == signature &&
+           header -> depth <= BIDIRECTIONAL_MAX_DEPTH / 2;
+}
+
+/**
+ *                       Loads the backward levels from a goal cache file.
+ *
+ * A file written for a larger depth holds the same shorter levels, so it is used too and
+ * only its levels 0 to depth are read.
+ *
+ * @param file_path             The path of the file.
+ * @param signature             The signature the levels must have been built for.
+ * @param depth                 The longest paths the levels must hold, at most the depth of the file.
+ * @param levels                Where to store levels 0 to depth, each sorted by state.
+ *
+ * @return                      True if the file exists, matches and is read, false otherwise (levels are left empty).
+ */
+bool goal_cache_load(const char* file_path, uint64_t signature, uint8_t depth, BidirectionalLevel* levels)
+{
+    FILE* file = fopen(file_path, "rb");
+    GoalCacheHeader header;
+
+    if (file == NULL)
+        return false;
+
+    if (!goal_cache_header_read(file, signature, &header) || header.depth < depth)
+    {
+        fclose(file);
+        return false;
+    }
+
+    uint8_t* buffer = (uint8_t*)(malloc(GOAL_CACHE_CHUNK * GOAL_CACHE_RECORD));
+    bool read = buffer != NULL;
+    uint8_t level = 0;
+
+    for (; read && level <= depth; level++)
+    {
+        levels[level].nodes = (BidirectionalNode*)(malloc((header.sizes[level] > 0 ? header.sizes[level] : 1) * sizeof(BidirectionalNode)));
+        levels[level].size = header.sizes[level];
+        levels[level].capacity = header.sizes[level];
+        read = levels[level].nodes != NULL;
+
+        for (size_t done = 0; read && done < header.sizes[level]; done += GOAL_CACHE_CHUNK)
+        {
+            const size_t count = header.sizes[level] - done < GOAL_CACHE_CHUNK ? header.sizes[level] - done : GOAL_CACHE_CHUNK;
+
+            read = fread(buffer, GOAL_CACHE_RECORD, count, file) == count;
+
+            for (size_t i = 0; read && i < count; i++)
+            {
+                BidirectionalNode* node = levels[level].nodes + done + i;
+
+                memcpy(&node -> key, buffer + i * GOAL_CACHE_RECORD, sizeof(uint64_t));
+                memcpy(&node -> steps, buffer + i * GOAL_CACHE_RECORD + 8, sizeof(uint64_t));
+                node -> move = buffer[i * GOAL_CACHE_RECORD + 16];
+            }
+        }
+    }
+
+    free(buffer);
+    fclose(file);
+
+    for (uint8_t i = 0; !read && i < level; i++)
+    {
+        free(levels[i].nodes);
+        memset(levels + i, 0, sizeof(BidirectionalLevel));
+    }
+
+    return read;
+}
+
+/**
+ *                       Saves the backward levels to a goal cache file.
+ *
+ * Every path is written as a packed record of GOAL_CACHE_RECORD bytes, so the file only
+ * depends on the levels. A file of the same signature that holds longer paths is kept,
+ * as the next queries with a larger goal_depth still need it.
+ *
+ * @param file_path             The path of the file, overwritten unless it holds longer paths.
+ * @param signature             The signature the levels were built for.
+ * @param depth                 The longest paths the levels hold.
+ * @param levels                Levels 0 to depth, each sorted by state.
+ *
+ * @return                      True if the file is written or a deeper one is kept.
+ */
+bool goal_cache_save(const char* file_path, uint64_t signature, uint8_t depth, const BidirectionalLevel* levels)
+{
+    FILE* file = fopen(file_path, "rb");
+    GoalCacheHeader header;
+
+    if (file != NULL)
+    {
+        const bool deeper = goal_cache_header_read(file, signature, &header) && header.depth > depth;
+
+        fclose(file);
+
+        if (deeper)
+            return true;
+    }
+
+    file = fopen(file_path, "wb");
+
+    if (file == NULL)
+        return false;
+
+    uint8_t* buffer = (uint8_t*)(malloc(GOAL_CACHE_CHUNK * GOAL_CACHE_RECORD));
+    bool written = buffer != NULL;
+
+    memset(&header, 0, sizeof(GoalCacheHeader));
+    header.magic = GOAL_CACHE_MAGIC;
+    header.version = GOAL_CACHE_VERSION;
+    header.signature = signature;
+    header.depth = depth;
+
+    for (uint8_t i = 0; i <= depth; i++)
+        header.sizes[i] = levels[i].size;
+
+    written &= fwrite(&header, sizeof(GoalCacheHeader), 1, file) == 1;
+
+    for (uint8_t level = 0; level <= depth && written; level++)
+    {
+        for (size_t done = 0; written && done < levels[level].size; done += GOAL_CACHE_CHUNK)
+        {
+            const size_t count = levels[level].size - done < GOAL_CACHE_CHUNK ? levels[level].size - done : GOAL_CACHE_CHUNK;
+
+            for (size_t i = 0; i < count; i++)
+            {
+                const BidirectionalNode* node = levels[level].nodes + done + i;
+
+                memcpy(buffer + i * GOAL_CACHE_RECORD, &node -> key, sizeof(uint64_t));
+                memcpy(buffer + i * GOAL_CACHE_RECORD + 8, &node -> steps, sizeof(uint64_t));
+                buffer[i * GOAL_CACHE_RECORD + 16] = node -> move;
+            }
+
+            written = fwrite(buffer, GOAL_CACHE_RECORD, count, file) == count;
+        }
+    }
+
+    free(buffer);
+    fclose(file);
+    return written;
+}
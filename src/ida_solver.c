@@ -0,0 +1,154 @@
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "ida_solver.h"
+#include "dfs_solver.h"
+#include "cube_rank.h"
+
+#define IDA_UNSOLVABLE 0xff // the lower bound of a cube no sequence of moves_map solves
+
+typedef struct ida_search
+{
+    const DistanceTable* corners;
+    const DistanceTable* edges; // NULL if the edges are ignored
+    uint64_t nodes; // how many cubes were expanded by the current search
+} IdaSearch;
+
+/**
+ *                       Looks up the distance of a cube in a pattern database.
+ *
+ * @param table                 The pattern database.
+ * @param index                 The index of the cube, as built by distance_table_index.
+ * @param context               The last move played, or DISTANCE_START.
+ *
+ * @return                      The distance, IDA_UNSOLVABLE if the table holds every distance and
+ *                               not this one, DISTANCE_UNKNOWN (more than DISTANCE_MAX) otherwise.
+ */
+static uint8_t ida_pattern_get(const DistanceTable* table, uint32_t index, uint8_t context)
+{
+    const uint8_t distance = distance_table_get(table, index, context);
+
+    return distance == DISTANCE_UNKNOWN && table -> depth < DISTANCE_MAX ? IDA_UNSOLVABLE : distance;
+}
+
+/**
+ *                       Looks up the lower bound of a cube after a context.
+ *
+ * @param search                The search.
+ * @param state                 The packed state.
+ * @param phase                 The edge phase.
+ * @param context               The last move played, or DISTANCE_START.
+ *
+ * @return                      The largest distance of the pattern databases, or IDA_UNSOLVABLE.
+ */
+static uint8_t ida_heuristic(const IdaSearch* search, uint32_t state, uint8_t phase, uint8_t context)
+{
+    const uint8_t corners = ida_pattern_get(search -> corners, corners_rank(state), context);
+
+    if (search -> edges == NULL || corners == IDA_UNSOLVABLE)
+        return corners;
+
+    const uint8_t edges = ida_pattern_get(search -> edges, distance_table_index(search -> edges, state, phase), context);
+
+    return edges > corners ? edges : corners;
+}
+
+/**
+ *                       Cuts the cubes that cannot be solved in the moves left.
+ *
+ * This is the prune hook IDA* gives dfs_iterator, so every iteration walks moves_map and
+ * tests the solutions exactly like the DFS. The cubes that are kept are counted.
+ *
+ * @param data                  The IdaSearch.
+ * @param state                 The packed state after the move.
+ * @param phase                 The edge phase after the move.
+ * @param last_move             The move.
+ * @param moves_left            How many moves are left before the bound.
+ *
+ * @return                      True if the lower bound of the cube is more than moves_left.
+ */
+static bool ida_cut(void* data, uint32_t state, uint8_t phase, uint8_t last_move, uint8_t moves_left)
+{
+    IdaSearch* search = (IdaSearch*)(data);
+
+    if (ida_heuristic(search, state, phase, last_move) > moves_left)
+        return true;
+
+    search -> nodes++;
+    return false;
+}
+
+/**
+ *                       Solves a cube using IDA* algorithm.
+ *
+ * This function runs depth-first searches along moves_map with a growing bound on the
+ * number of moves, starting at the lower bound of the initial cube. A branch is cut as
+ * soon as its length plus the lower bound of its cube exceeds the bound. The lower bound
+ * is the largest distance of the corners and of the edges alone, looked up in their
+ * pattern databases. All the solutions of the first bound that has any are printed, so
+ * they are optimal like the BFS ones while the memory stays that of the DFS.
+ *
+ * @param moves_map             A 2D array of moves to use for solving the cube.
+ * @param original_states       An array of original states to check against.
+ * @param state                 The initial state of the cube.
+ * @param edges_phase_state     The initial edge phase of the cube.
+ * @param min_depth             The minimum depth of the solution.
+ * @param max_depth             The maximum depth of the solution.
+ * @param corners               The distance table of the corners alone.
+ * @param edges                 The distance table of the edges alone, or NULL if the edges are ignored.
+ */
+void cube_ida_solver(const Move* moves_map, const int* original_states,
+                     uint32_t state, uint8_t edges_phase_state, uint8_t min_depth, uint8_t max_depth,
+                     const DistanceTable* corners, const DistanceTable* edges)
+{
+    const uint8_t moves_size = 19;
+    const Move ALL_MOVES[19] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2};
+    const bool edges_all0 = (state & 0xffu) == 0;
+    IdaSearch search = {corners, edges, 0};
+    const DfsPrune prune = {ida_cut, &search};
+    DfsSolutions solutions = {0, false, NULL, 0, NULL};
+    uint64_t current_time = get_current_time();
+
+    puts("start searching");
+    edge_phase_table_init();
+
+    const uint8_t heuristic = ida_heuristic(&search, state, edges_phase_state, DISTANCE_START);
+
+    if (max_depth >= DFS_MAX_DEPTH)
+        max_depth = DFS_MAX_DEPTH - 1;
+
+    if (heuristic == IDA_UNSOLVABLE)
+        printf("lower bound: unknown (not solvable with the moves map)\n");
+    else
+        printf("lower bound: %d\n", heuristic);
+
+    // a solution is at least one move long, like the DFS ones
+    uint8_t bound = heuristic > min_depth ? heuristic : min_depth;
+    bound = bound > 1 ? bound : 1;
+
+    for (; heuristic != IDA_UNSOLVABLE && bound <= max_depth && solutions.count == 0; bound++)
+    {
+        search.nodes = 0;
+
+        for (uint8_t i = 0; i < moves_size; i++)
+        {
+            if (moves_map[i * moves_size + 1].transform == NULL)
+                continue;
+
+            const uint32_t new_state = ALL_MOVES[i].transform(state);
+            const uint8_t new_phase = EDGE_PHASE_TABLE[i][edges_phase_state];
+
+            if (ida_cut(&search, new_state, new_phase, i, bound - 1))
+                continue;
+
+            // the paths are searched up to the bound, the prune hook cuts the ones that cannot be solved in it
+            dfs_iterator(new_state, new_phase, edges_all0, &i, 1, moves_map, original_states, min_depth, bound, &solutions,
+                         NULL, NULL, &prune);
+        }
+
+        printf("bound %d: %" PRIu64 " nodes\n", bound, search.nodes);
+    }
+
+    printf("search end in %lf (s), find total %u solutions: ", (get_current_time() - current_time) / 1000.0, solutions.count);
+}
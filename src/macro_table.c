@@ -0,0 +1,297 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macro_table.h"
+
+typedef struct macro_candidate
+{
+    uint64_t key; // net permutation, next moves allowed and length
+    uint32_t order; // position in the enumeration, the first one wins
+    Macro macro;
+} MacroCandidate;
+
+typedef struct macro_candidates
+{
+    uint32_t size;
+    uint32_t capacity;
+    MacroCandidate* items;
+} MacroCandidates;
+
+typedef struct macro_moves
+{
+    const Move* moves; // the moves by serial
+    int8_t successors[MACRO_CONTEXTS][20]; // successors[c] lists the serials allowed after context c, ended by -1
+    uint8_t rows[19]; // the smallest serial allowing the same next moves
+    uint8_t length; // the longest sequences
+    bool edges_all0;
+} MacroMoves;
+
+/**
+ *                       Computes the key of a sequence of moves.
+ *
+ * Every move only permutes the corner and edge fields, so the net permutation is told
+ * apart by its effect on the solved state. The edge phase is a permutation of 8 bits,
+ * it is stored as the new position of every bit.
+ *
+ * @param moves                 The moves of the table.
+ * @param macro                 The sequence.
+ *
+ * @return                      The net permutation, the row of the last move and the length.
+ */
+static uint64_t macro_key(const MacroMoves* moves, const Macro* macro)
+{
+    uint32_t state = moves -> edges_all0 ? 87652123 & 0xffffff00 : 87652123;
+    uint32_t phase = 0;
+
+    for (uint8_t i = 0; i < macro -> length; i++)
+        state = moves -> moves[macro -> serials[i]].transform(state);
+
+    for (uint8_t k = 0; k < 8 && !moves -> edges_all0; k++)
+    {
+        uint8_t bit = 1 << k;
+
+        for (uint8_t i = 0; i < macro -> length; i++)
+            bit = edge_transform(bit, macro -> serials[i]);
+
+        phase |= __builtin_ctz(bit) << (3 * k);
+    }
+
+    return (uint64_t)(state) << 32 | (uint64_t)(phase) << 7 | moves -> rows[macro -> serials[macro -> length - 1]] << 2 |
+           macro -> length;
+}
+
+/**
+ *                       Enumerates every allowed sequence that starts after a context, depth first.
+ *
+ * @param candidates            Where to append the sequences.
+ * @param moves                 The moves of the table.
+ * @param context               The last move played, or MACRO_START.
+ * @param macro                 The sequence built so far.
+ *
+ * @return                      False if out of memory.
+ */
+static bool macro_enumerate(MacroCandidates* candidates, const MacroMoves* moves, uint8_t context, Macro* macro)
+{
+    if (macro -> length == moves -> length)
+        return true;
+
+    for (uint8_t i = 0; moves -> successors[context][i] >= 0; i++)
+    {
+        if (candidates -> size == candidates -> capacity)
+        {
+            const uint32_t capacity = candidates -> capacity == 0 ? 1024 : candidates -> capacity * 2;
+            MacroCandidate* items = (MacroCandidate*)(realloc(candidates -> items, capacity * sizeof(MacroCandidate)));
+
+            if (items == NULL)
+                return false;
+
+            candidates -> items = items;
+            candidates -> capacity = capacity;
+        }
+
+        MacroCandidate* candidate = candidates -> items + candidates -> size;
+
+        macro -> serials[macro -> length++] = moves -> successors[context][i];
+        candidate -> macro = *macro;
+        candidate -> key = macro_key(moves, macro);
+        candidate -> order = candidates -> size++;
+
+        if (!macro_enumerate(candidates, moves, macro -> serials[macro -> length - 1], macro))
+            return false;
+
+        macro -> length--;
+    }
+
+    return true;
+}
+
+static int macro_compare_key(const void* a, const void* b)
+{
+    const MacroCandidate* x = (const MacroCandidate*)(a);
+    const MacroCandidate* y = (const MacroCandidate*)(b);
+
+    if (x -> key != y -> key)
+        return x -> key < y -> key ? -1 : 1;
+
+    return x -> order < y -> order ? -1 : x -> order > y -> order;
+}
+
+static int macro_compare_order(const void* a, const void* b)
+{
+    const MacroCandidate* x = (const MacroCandidate*)(a);
+    const MacroCandidate* y = (const MacroCandidate*)(b);
+
+    return x -> order < y -> order ? -1 : x -> order > y -> order;
+}
+
+/**
+ *                       Builds the macro moves of up to a given length.
+ *
+ * This function enumerates, for every context (the last move played, or MACRO_START),
+ * every sequence of 1 to length moves allowed by moves_map, and keeps the first one (in
+ * moves_map order) of every distinct net permutation. Two sequences are only merged if
+ * their last moves allow the same next moves, so stepping by macros reaches every state
+ * the plain sequences reach. When edges_all0 is true, only the corner permutation counts.
+ *
+ * The macros of a context are stored depth first, a sequence right before its extensions,
+ * so a search walks them like a tree and applies one move per macro. Sequences that are
+ * not kept stay in the list when a kept sequence extends them.
+ *
+ * @param table                 The table to build.
+ * @param moves_map             A 2D array of moves (19 x 19), as given to the solvers.
+ * @param length                The longest macros, 1 to MACRO_MAX_LENGTH.
+ * @param edges_all0            A boolean indicating whether the edges are ignored.
+ *
+ * @return                      True if the table is built, false if out of memory.
+ */
+bool macro_table_create(MacroTable* table, const Move* moves_map, uint8_t length, bool edges_all0)
+{
+    const uint8_t moves_size = 19;
+    MacroMoves moves = {.moves = table -> moves, .length = length, .edges_all0 = edges_all0};
+    MacroCandidates candidates = {0, 0, NULL};
+
+    memset(table, 0, sizeof(MacroTable));
+    table -> length = length;
+
+    for (uint8_t i = 0; i < moves_size; i++)
+        table -> moves[i] = EMPTY;
+
+    // the moves by serial, with the transform functions the solver uses
+    for (uint16_t i = 0; i < moves_size * moves_size; i++)
+    {
+        if (moves_map[i].transform != NULL)
+            table -> moves[moves_map[i].serial] = moves_map[i];
+    }
+
+    // the same first moves as cube_dfs_solver: every move whose row allows a second move
+    uint8_t first_size = 0;
+
+    for (uint8_t i = 0; i < moves_size; i++)
+    {
+        uint8_t size = 0;
+
+        for (uint8_t j = 1; j < moves_size && moves_map[i * moves_size + j].transform != NULL; j++)
+            moves.successors[i][size++] = moves_map[i * moves_size + j].serial;
+
+        moves.successors[i][size] = -1;
+
+        if (size != 0)
+            moves.successors[MACRO_START][first_size++] = i;
+    }
+
+    moves.successors[MACRO_START][first_size] = -1;
+
+    for (uint8_t i = 0; i < moves_size; i++)
+    {
+        uint8_t size = 0;
+
+        while (moves.successors[i][size] >= 0)
+            size++;
+
+        moves.rows[i] = i;
+
+        for (uint8_t j = 0; j < i; j++)
+        {
+            if (memcmp(moves.successors[j], moves.successors[i], size + 1) == 0)
+            {
+                moves.rows[i] = j;
+                break;
+            }
+        }
+    }
+
+    for (uint8_t context = 0; context < MACRO_CONTEXTS; context++)
+    {
+        Macro macro = {.length = 0, .kept = false};
+        candidates.size = 0;
+
+        if (!macro_enumerate(&candidates, &moves, context, &macro))
+        {
+            free(candidates.items);
+            macro_table_free(table);
+            return false;
+        }
+
+        if (candidates.size == 0)
+            continue;
+
+        // keep the first sequence of every key, then restore the depth first order
+        qsort(candidates.items, candidates.size, sizeof(MacroCandidate), macro_compare_key);
+
+        for (uint32_t i = 0; i < candidates.size; i++)
+        {
+            Macro* candidate = &candidates.items[i].macro;
+            candidate -> kept = i == 0 || candidates.items[i].key != candidates.items[i - 1].key;
+            table -> sequences[candidate -> length - 1]++;
+            table -> distinct[candidate -> length - 1] += candidate -> kept;
+        }
+
+        qsort(candidates.items, candidates.size, sizeof(MacroCandidate), macro_compare_order);
+
+        // walking backwards, a sequence is needed if it is kept or one of its extensions is needed
+        bool needed_below[MACRO_MAX_LENGTH + 1] = {false};
+        uint32_t size = 0;
+
+        for (uint32_t i = candidates.size; i-- > 0;)
+        {
+            const Macro* candidate = &candidates.items[i].macro;
+            const bool needed = candidate -> kept || needed_below[candidate -> length];
+
+            needed_below[candidate -> length] = false;
+            needed_below[candidate -> length - 1] |= needed;
+            candidates.items[i].order = needed;
+            size += needed;
+        }
+
+        table -> macros[context] = (Macro*)(malloc(size * sizeof(Macro)));
+
+        if (table -> macros[context] == NULL)
+        {
+            free(candidates.items);
+            macro_table_free(table);
+            return false;
+        }
+
+        for (uint32_t i = 0; i < candidates.size; i++)
+        {
+            if (candidates.items[i].order)
+                table -> macros[context][table -> size[context]++] = candidates.items[i].macro;
+        }
+
+        // the extensions of a macro end at the next macro that is not longer
+        uint32_t open[MACRO_MAX_LENGTH];
+        uint8_t open_size = 0;
+
+        for (uint32_t i = 0; i < size; i++)
+        {
+            Macro* macro = table -> macros[context] + i;
+
+            while (open_size > 0 && table -> macros[context][open[open_size - 1]].length >= macro -> length)
+                table -> macros[context][open[--open_size]].next = i;
+
+            open[open_size++] = i;
+        }
+
+        while (open_size > 0)
+            table -> macros[context][open[--open_size]].next = size;
+    }
+
+    free(candidates.items);
+    return true;
+}
+
+/**
+ *                       Frees all the memory allocated by a macro table.
+ *
+ * @param table                 The table to free.
+ */
+void macro_table_free(MacroTable* table)
+{
+    for (uint8_t i = 0; i < MACRO_CONTEXTS; i++)
+    {
+        free(table -> macros[i]);
+        table -> macros[i] = NULL;
+        table -> size[i] = 0;
+    }
+}
@@ -7,6 +7,8 @@
 
 #include "utils.h"
 #include "cube_solver.h"
+#include "move_bitslice.h"
+#include "move_dispatch.h"
 
 /**
  * Benchmark all moves of the rubik cube.
@@ -37,6 +39,60 @@ void bench_mark()
 
         printf("move: %s, time: %lf (s / 1 billion times call)\n", move.symbol, (get_current_time() - current_time) / 1000.0);
     }
+
+    // BMI2 kernels of the face moves
+    if (move_bmi2_supported())
+    {
+        const Move BMI2_MOVES[4] = {
+            {.serial = 0, .symbol = "R\0", .transform = R_transform_bmi2},
+            {.serial = 1, .symbol = "L\0", .transform = L_transform_bmi2},
+            {.serial = 2, .symbol = "F\0", .transform = F_transform_bmi2},
+            {.serial = 3, .symbol = "B\0", .transform = B_transform_bmi2}
+        };
+
+        for (uint8_t i = 0; i < sizeof(BMI2_MOVES) / sizeof(BMI2_MOVES[0]); i++)
+        {
+            number = rand();
+            const Move move = BMI2_MOVES[i];
+
+            uint64_t current_time = get_current_time();
+
+            for (uint64_t i = 0; i < 1e9; i++)
+                number = move.transform(number);
+
+            printf("move: %s (bmi2), time: %lf (s / 1 billion times call)\n", move.symbol, (get_current_time() - current_time) / 1000.0);
+        }
+    }
+
+    // kernels picked by the runtime dispatch
+    printf("cpu: bmi2 %s, avx2 %s\n", move_bmi2_supported() ? "yes" : "no", move_simd_supported() ? "yes" : "no");
+
+    for (uint8_t i = 0; i < sizeof(ALL_MOVES) / sizeof(ALL_MOVES[0]); i++)
+        printf("dispatch: %s => %s, batch => %s\n", ALL_MOVES[i].symbol, move_dispatch_name(i, false), move_dispatch_name(i, true));
+
+    // bit-sliced engine, every call moves BITSLICE_LANES states at once
+    const int ALL_ORIGINAL_STATES[8] = {-1622093511, -1277027762, -697023597, -87652124, 87652123, 697023596, 1277027761, 1622093510};
+    uint32_t states[BITSLICE_LANES];
+    uint64_t hits[BITSLICE_WORDS];
+    BitSlice slice;
+
+    for (uint16_t i = 0; i < BITSLICE_LANES; i++)
+        states[i] = rand();
+
+    bitslice_transpose_in(&slice, states, BITSLICE_LANES);
+    uint64_t current_time = get_current_time();
+
+    for (uint64_t i = 0; i < 1e9 / BITSLICE_LANES; i++)
+        bitslice_apply(&slice, i % 19);
+
+    printf("move: bit-sliced (%d lanes), time: %lf (s / 1 billion states moved)\n", BITSLICE_LANES, (get_current_time() - current_time) / 1000.0);
+    current_time = get_current_time();
+
+    for (uint64_t i = 0; i < 1e8 / BITSLICE_LANES; i++)
+        bitslice_original_state(&slice, ALL_ORIGINAL_STATES, hits);
+
+    bitslice_transpose_out(&slice, states, BITSLICE_LANES);
+    printf("goal check: bit-sliced (%d lanes), time: %lf (s / 100 million states checked)\n", BITSLICE_LANES, (get_current_time() - current_time) / 1000.0);
 }
 
 /**
@@ -86,14 +142,15 @@ int main(int argc, char const *argv[])
 
     if (has_argv(argc, argv, "-f", "--file"))
     {
-        char res[2048] = "\0";
         char* file_path = (char*)(get_argv(argc, argv, "-f", "--file"));
 
         if (file_path == NULL)
             file_path = "settings.json\0";
 
-        read_from_file(res, file_path);
-        cJSON* json = cJSON_Parse(res);
+        char* res = read_from_file(file_path);
+        cJSON* json = res != NULL ? cJSON_Parse(res) : NULL;
+
+        free(res);
 
         // solve cube
         cube_solver(json); 
@@ -116,6 +116,96 @@ uint32_t B_transform(uint32_t state)
     return state;
 }
 
+#define BMI2 __attribute__((target("bmi2")))
+
+/**
+ * face_transform_bmi2: shared BMI2 kernel of the R, L, F and B moves
+ *
+ * Each of these moves reverses the order of its 4 corners and swaps its 2 edges. The
+ * fields are gathered next to each other with pext, reversed with a rotation and an
+ * adjacent swap, then scattered back with pdep.
+ *
+ * @state:                      32-bit representation of corner and edge phases
+ * @corners:                    mask of the 4 corner fields moved by the face
+ * @edges:                      mask of the 2 edge fields moved by the face
+ * @return:                     transformed corner and edge phases
+ */
+static inline BMI2 uint32_t face_transform_bmi2(uint32_t state, uint32_t corners, uint32_t edges)
+{
+    uint32_t c = _pext_u32(state, corners); // abcd => cdab => dcba
+    uint32_t e = _pext_u32(state, edges);
+
+    c = (c >> 6 | c << 6) & 0xfff;
+    c = (c >> 3 & 0b000111000111) | (c << 3 & 0b111000111000);
+    e = (e >> 2 | e << 2) & 0b1111;
+
+    return (state & ~(corners | edges)) | _pdep_u32(c, corners) | _pdep_u32(e, edges);
+}
+
+/**
+ * R_transform_bmi2: BMI2 version of R_transform
+ *
+ * @state:                      32-bit representation of corner and edge phases
+ * @return:                     transformed corner and edge phases
+ */
+BMI2 uint32_t R_transform_bmi2(uint32_t state)
+{
+    return face_transform_bmi2(state, 0b111 << 23 | 0b111 << 20 | 0b111 << 11 | 0b111 << 8, 0b11 << 2 | 0b11);
+}
+
+/**
+ * L_transform_bmi2: BMI2 version of L_transform
+ *
+ * @state:                      32-bit representation of corner and edge phases
+ * @return:                     transformed corner and edge phases
+ */
+BMI2 uint32_t L_transform_bmi2(uint32_t state)
+{
+    return face_transform_bmi2(state, 0b111u << 29 | 0b111 << 26 | 0b111 << 17 | 0b111 << 14, 0b11 << 6 | 0b11 << 4);
+}
+
+/**
+ * F_transform_bmi2: BMI2 version of F_transform
+ *
+ * @state:                      32-bit representation of corner and edge phases
+ * @return:                     transformed corner and edge phases
+ */
+BMI2 uint32_t F_transform_bmi2(uint32_t state)
+{
+    return face_transform_bmi2(state, 0b111u << 29 | 0b111 << 20 | 0b111 << 17 | 0b111 << 8, 0b11 << 6 | 0b11);
+}
+
+/**
+ * B_transform_bmi2: BMI2 version of B_transform
+ *
+ * @state:                      32-bit representation of corner and edge phases
+ * @return:                     transformed corner and edge phases
+ */
+BMI2 uint32_t B_transform_bmi2(uint32_t state)
+{
+    return face_transform_bmi2(state, 0b111 << 26 | 0b111 << 23 | 0b111 << 14 | 0b111 << 11, 0b11 << 4 | 0b11 << 2);
+}
+
+static bool bmi2_checked = false;
+static bool bmi2_supported = false;
+
+/**
+ * move_bmi2_supported: checks if the CPU can run the *_transform_bmi2 functions
+ *
+ * @return:                     true if BMI2 is available, false otherwise
+ */
+bool move_bmi2_supported()
+{
+    if (!bmi2_checked)
+    {
+        __builtin_cpu_init();
+        bmi2_supported = __builtin_cpu_supports("bmi2");
+        bmi2_checked = true;
+    }
+
+    return bmi2_supported;
+}
+
 /**
  * U_transform: corner phase check for U move
  * corners: 0123 4567 => 0653 4217, edges: 0123 => 0213
@@ -564,10 +654,84 @@ uint8_t edge_R_transform(uint8_t state)
     return swap_bits(swap_bits(state, 6, 7), 5, 0);
 }
 
-const Move R = {.serial = 0, .symbol = "R\0", .transform = R_transform};
-const Move L = {.serial = 1, .symbol = "L\0", .transform = L_transform};
-const Move F = {.serial = 2, .symbol = "F\0", .transform = F_transform};
-const Move B = {.serial = 3, .symbol = "B\0", .transform = B_transform};
+/**
+ * edge_transform: edge phase check for any move
+ *
+ * @state:                      8-bit representation of edge phase
+ * @serial:                     the serial of the move (R = 0 ... Dw2 = 18)
+ * @return:                     transformed edge phase
+ *
+ * U and D moves do not change the edge phase, the wide moves change it like
+ * the E move they contain (Dw turns the middle layer like E').
+ */
+uint8_t edge_transform(uint8_t state, uint8_t serial)
+{
+    switch (serial)
+    {
+        case 0: return edge_R_transform(state);
+        case 1: return edge_L_transform(state);
+        case 2: return edge_F_transform(state);
+        case 3: return edge_B_transform(state);
+        case 7:
+        case 13:
+        case 17: return edge_E_transform(state);
+        case 8:
+        case 14:
+        case 16: return edge_EPrime_transform(state);
+        case 9:
+        case 15:
+        case 18: return edge_E2_transform(state);
+        default: return state;
+    }
+}
+
+uint8_t EDGE_PHASE_TABLE[19][256];
+
+/**
+ * edge_phase_table_init: fills EDGE_PHASE_TABLE
+ *
+ * EDGE_PHASE_TABLE[serial][phase] is edge_transform(phase, serial), so the solvers can
+ * carry the edge phase along a path with one lookup per move instead of replaying the
+ * whole path. Calling it again does nothing.
+ */
+void edge_phase_table_init()
+{
+    static bool initialized = false;
+
+    if (initialized)
+        return;
+
+    for (uint8_t serial = 0; serial < 19; serial++)
+    {
+        for (uint16_t phase = 0; phase < 256; phase++)
+            EDGE_PHASE_TABLE[serial][phase] = edge_transform(phase, serial);
+    }
+
+    initialized = true;
+}
+
+/**
+ * edge_phase_solved: checks if an edge phase is solved
+ *
+ * @phase:                      8-bit representation of edge phase
+ * @return:                     true if the phase is 3 or one of its E turns
+ */
+bool edge_phase_solved(uint8_t phase)
+{
+    return phase == 3 || phase == 12 || phase == 48 || phase == 192;
+}
+
+// built with -DCUBE_MOVE_BMI2 (cmake -DCUBE_MOVE_BMI2=ON), the face moves use the pext / pdep kernels
+#ifdef CUBE_MOVE_BMI2
+    #define FACE_TRANSFORM(name) name##_transform_bmi2
+#else
+    #define FACE_TRANSFORM(name) name##_transform
+#endif
+
+const Move R = {.serial = 0, .symbol = "R\0", .transform = FACE_TRANSFORM(R)};
+const Move L = {.serial = 1, .symbol = "L\0", .transform = FACE_TRANSFORM(L)};
+const Move F = {.serial = 2, .symbol = "F\0", .transform = FACE_TRANSFORM(F)};
+const Move B = {.serial = 3, .symbol = "B\0", .transform = FACE_TRANSFORM(B)};
 
 const Move U = {.serial = 4, .symbol = "U\0", .transform = U_transform};
 const Move UPrime = {.serial = 5, .symbol = "U'\0", .transform = UPrime_transform};
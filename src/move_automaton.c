@@ -0,0 +1,458 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "move_automaton.h"
+
+#define AUTOMATON_CONTEXTS 20 // the last move (R = 0 ... Dw2 = 18) or the start of the path
+#define AUTOMATON_BEFORE_FIRST 19 // the context of the sequences that start the path
+#define AUTOMATON_NONE UINT32_MAX // no node
+
+typedef struct automaton_node
+{
+    uint32_t state; // the probe state after the moves
+    uint32_t phase; // the new position of every edge phase bit after the moves, 3 bits each
+    uint32_t suffix; // the same moves without the first one, which becomes their context
+    uint32_t children; // where the 19 children are in AutomatonBuilder -> children, AUTOMATON_NONE at the longest level
+    uint8_t context; // the move before the sequence, or AUTOMATON_BEFORE_FIRST
+    uint8_t serial; // the last move, the context itself for the empty sequence
+    uint8_t level; // how many moves
+} AutomatonNode;
+
+typedef struct automaton_builder
+{
+    const Move* moves; // the moves by serial
+    int8_t successors[AUTOMATON_CONTEXTS][20]; // successors[c] lists the serials allowed after context c, ended by -1
+    uint32_t exits[AUTOMATON_CONTEXTS]; // the same as bit masks
+    uint8_t length;
+    bool edges_all0;
+    AutomatonNode* nodes; // the sequences kept, level by level, the empty sequence of context c first at index c
+    uint32_t size;
+    uint32_t capacity;
+    uint32_t* children; // children[node.children + s]: the sequence followed by move s, AUTOMATON_NONE if not kept
+    uint32_t children_size;
+    uint32_t children_capacity;
+    uint32_t* hash; // the nodes by key, open addressing, node + 1 or 0 if empty
+    uint32_t hash_capacity; // a power of 2
+} AutomatonBuilder;
+
+/**
+ *                       Hashes the key of a node.
+ *
+ * Two sequences share a key if they have the same context, the same net permutation and
+ * allow the same next moves.
+ *
+ * @param builder               The builder.
+ * @param node                  The node.
+ *
+ * @return                      The slot of the node in a table of builder -> hash_capacity slots.
+ */
+static uint32_t automaton_slot(const AutomatonBuilder* builder, const AutomatonNode* node)
+{
+    uint64_t key = ((uint64_t)(node -> state) << 32 | node -> phase) ^
+                   ((uint64_t)(builder -> exits[node -> serial]) << 5 | node -> context) * 0x9e3779b97f4a7c15ull;
+
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+
+    return key & (builder -> hash_capacity - 1);
+}
+
+/**
+ *                       Checks if two nodes share a key.
+ *
+ * @param builder               The builder.
+ * @param a                     The first node.
+ * @param b                     The second node.
+ *
+ * @return                      True if either sequence can replace the other one.
+ */
+static bool automaton_same(const AutomatonBuilder* builder, const AutomatonNode* a, const AutomatonNode* b)
+{
+    return a -> state == b -> state && a -> phase == b -> phase && a -> context == b -> context &&
+           builder -> exits[a -> serial] == builder -> exits[b -> serial];
+}
+
+/**
+ *                       Looks up a sequence with the same key as a node.
+ *
+ * @param builder               The builder.
+ * @param node                  The node, not in the builder yet.
+ *
+ * @return                      True if an earlier sequence has the same key.
+ */
+static bool automaton_find(const AutomatonBuilder* builder, const AutomatonNode* node)
+{
+    for (uint32_t slot = automaton_slot(builder, node); builder -> hash[slot] != 0; slot = (slot + 1) & (builder -> hash_capacity - 1))
+    {
+        if (automaton_same(builder, builder -> nodes + builder -> hash[slot] - 1, node))
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ *                       Adds a node to the builder and to the hash table.
+ *
+ * @param builder               The builder.
+ * @param node                  The node, whose key is not in the builder yet.
+ *
+ * @return                      The index of the node, AUTOMATON_NONE if out of memory.
+ */
+static uint32_t automaton_push(AutomatonBuilder* builder, AutomatonNode node)
+{
+    if (builder -> size == builder -> capacity)
+    {
+        const uint32_t capacity = builder -> capacity == 0 ? 1024 : builder -> capacity * 2;
+        AutomatonNode* nodes = (AutomatonNode*)(realloc(builder -> nodes, capacity * sizeof(AutomatonNode)));
+
+        if (nodes == NULL)
+            return AUTOMATON_NONE;
+
+        builder -> nodes = nodes;
+        builder -> capacity = capacity;
+    }
+
+    // only the sequences shorter than length are extended
+    if (node.level < builder -> length)
+    {
+        if (builder -> children_size + 19 > builder -> children_capacity)
+        {
+            const uint32_t capacity = builder -> children_capacity == 0 ? 19 * 1024 : builder -> children_capacity * 2;
+            uint32_t* children = (uint32_t*)(realloc(builder -> children, capacity * sizeof(uint32_t)));
+
+            if (children == NULL)
+                return AUTOMATON_NONE;
+
+            builder -> children = children;
+            builder -> children_capacity = capacity;
+        }
+
+        node.children = builder -> children_size;
+        builder -> children_size += 19;
+
+        for (uint8_t i = 0; i < 19; i++)
+            builder -> children[node.children + i] = AUTOMATON_NONE;
+    }
+
+    // the table is kept at most half full
+    if (2 * (builder -> size + 1) > builder -> hash_capacity)
+    {
+        const uint32_t capacity = builder -> hash_capacity == 0 ? 4096 : builder -> hash_capacity * 2;
+        uint32_t* hash = (uint32_t*)(calloc(capacity, sizeof(uint32_t)));
+
+        if (hash == NULL)
+            return AUTOMATON_NONE;
+
+        free(builder -> hash);
+        builder -> hash = hash;
+        builder -> hash_capacity = capacity;
+
+        for (uint32_t i = 0; i < builder -> size; i++)
+        {
+            uint32_t slot = automaton_slot(builder, builder -> nodes + i);
+
+            while (builder -> hash[slot] != 0)
+                slot = (slot + 1) & (capacity - 1);
+
+            builder -> hash[slot] = i + 1;
+        }
+    }
+
+    uint32_t slot = automaton_slot(builder, &node);
+
+    while (builder -> hash[slot] != 0)
+        slot = (slot + 1) & (builder -> hash_capacity - 1);
+
+    builder -> hash[slot] = builder -> size + 1;
+    builder -> nodes[builder -> size] = node;
+
+    return builder -> size++;
+}
+
+/**
+ *                       Applies a move to the edge phase bits of a node.
+ *
+ * @param phase                 The position of every edge phase bit, 3 bits each.
+ * @param serial                The move.
+ *
+ * @return                      The positions after the move.
+ */
+static uint32_t automaton_phase(uint32_t phase, uint8_t serial)
+{
+    uint32_t next = 0;
+
+    for (uint8_t k = 0; k < 8; k++)
+        next |= (uint32_t)(__builtin_ctz(EDGE_PHASE_TABLE[serial][1 << (phase >> (3 * k) & 7)])) << (3 * k);
+
+    return next;
+}
+
+/**
+ *                       Builds the automaton that only allows the first of every redundant sequence.
+ *
+ * This function enumerates, for every context (the last move played, or the start of the
+ * path), the sequences of 1 to length moves allowed by moves_map, shortest first and in
+ * moves_map order, and hashes the net permutation of every one. A sequence is forbidden
+ * if an earlier one of the same context has the same net permutation and its last move
+ * allows the same next moves, as the earlier one can replace it in any path. The earlier
+ * one may be shorter, down to no move at all. When edges_all0 is true, only the corner
+ * permutation counts.
+ *
+ * A path is allowed if none of its sequences of up to length moves is forbidden. The
+ * states of the automaton are the last moves of a path that still matter, so stepping it
+ * replaces the moves_map row of the last move. Every cube keeps its first shortest path,
+ * so the shortest solution length does not change.
+ *
+ * @param automaton             The automaton to build.
+ * @param moves_map             A 2D array of moves (19 x 19), as given to the solvers.
+ * @param length                The longest sequences compared, 1 to AUTOMATON_MAX_LENGTH.
+ * @param edges_all0            A boolean indicating whether the edges are ignored.
+ *
+ * @return                      True if the automaton is built, false if out of memory.
+ */
+bool move_automaton_create(MoveAutomaton* automaton, const Move* moves_map, uint8_t length, bool edges_all0)
+{
+    const uint8_t moves_size = 19;
+    AutomatonBuilder builder = {.moves = automaton -> moves, .length = length, .edges_all0 = edges_all0};
+    bool failed = false;
+
+    memset(automaton, 0, sizeof(MoveAutomaton));
+    automaton -> length = length;
+    edge_phase_table_init();
+
+    for (uint8_t i = 0; i < moves_size; i++)
+        automaton -> moves[i] = EMPTY;
+
+    // the moves by serial, with the transform functions the solver uses
+    for (uint16_t i = 0; i < moves_size * moves_size; i++)
+    {
+        if (moves_map[i].transform != NULL)
+            automaton -> moves[moves_map[i].serial] = moves_map[i];
+    }
+
+    // the same first moves as the solvers: every move whose row allows a second move
+    uint8_t first_size = 0;
+
+    for (uint8_t i = 0; i < moves_size; i++)
+    {
+        uint8_t size = 0;
+
+        for (uint8_t j = 1; j < moves_size && moves_map[i * moves_size + j].transform != NULL; j++)
+        {
+            builder.successors[i][size++] = moves_map[i * moves_size + j].serial;
+            builder.exits[i] |= 1u << moves_map[i * moves_size + j].serial;
+        }
+
+        builder.successors[i][size] = -1;
+
+        if (size != 0)
+        {
+            builder.successors[AUTOMATON_BEFORE_FIRST][first_size++] = i;
+            builder.exits[AUTOMATON_BEFORE_FIRST] |= 1u << i;
+        }
+    }
+
+    builder.successors[AUTOMATON_BEFORE_FIRST][first_size] = -1;
+
+    // every position holds its own piece, so different permutations give different states
+    uint32_t probe = 0;
+    uint32_t identity = 0;
+
+    for (uint8_t i = 0; i < 8; i++)
+        probe |= (uint32_t)(i) << (29 - 3 * i);
+
+    for (uint8_t i = 0; i < 4 && !edges_all0; i++)
+        probe |= (uint32_t)(i) << (6 - 2 * i);
+
+    for (uint8_t k = 0; k < 8 && !edges_all0; k++)
+        identity |= (uint32_t)(k) << (3 * k);
+
+    // the empty sequence of every context, at the index of the context
+    for (uint8_t c = 0; c < AUTOMATON_CONTEXTS && !failed; c++)
+        failed = automaton_push(&builder, (AutomatonNode){probe, identity, AUTOMATON_NONE, AUTOMATON_NONE, c, c, 0}) == AUTOMATON_NONE;
+
+    uint32_t begin = 0;
+    uint32_t end = builder.size;
+
+    // the sequences of every length extend the kept ones of the length before, in the same order
+    for (uint8_t level = 1; level <= length && !failed; level++)
+    {
+        for (uint32_t i = begin; i < end && !failed; i++)
+        {
+            const AutomatonNode parent = builder.nodes[i];
+
+            for (uint8_t j = 0; builder.successors[parent.serial][j] >= 0 && !failed; j++)
+            {
+                const uint8_t serial = builder.successors[parent.serial][j];
+
+                // the moves after the first one must be kept in the context of the first one
+                const uint32_t suffix = parent.level == 0 ? serial : builder.children[builder.nodes[parent.suffix].children + serial];
+
+                if (suffix == AUTOMATON_NONE)
+                    continue;
+
+                const AutomatonNode node = {builder.moves[serial].transform(parent.state),
+                                            edges_all0 ? 0 : automaton_phase(parent.phase, serial),
+                                            suffix, AUTOMATON_NONE, parent.context, serial, level};
+
+                if (automaton_find(&builder, &node))
+                    continue;
+
+                const uint32_t index = automaton_push(&builder, node);
+
+                failed = index == AUTOMATON_NONE;
+
+                if (!failed)
+                    builder.children[parent.children + serial] = index;
+            }
+        }
+
+        begin = end;
+        end = builder.size;
+    }
+
+    // the states are the nodes reached from the start, numbered in the order they are found
+    uint32_t* states = (uint32_t*)(malloc(builder.size * sizeof(uint32_t) + 1));
+    uint32_t* queue = (uint32_t*)(malloc(builder.size * sizeof(uint32_t) + 1));
+
+    automaton -> first = (uint32_t*)(malloc((builder.size + 1) * sizeof(uint32_t)));
+    automaton -> serials = (uint8_t*)(malloc(builder.children_size * sizeof(uint8_t) + 1));
+    automaton -> targets = (uint32_t*)(malloc(builder.children_size * sizeof(uint32_t) + 1));
+    failed |= states == NULL || queue == NULL || automaton -> first == NULL || automaton -> serials == NULL || automaton -> targets == NULL;
+
+    if (!failed)
+    {
+        uint32_t transitions = 0;
+
+        for (uint32_t i = 0; i < builder.size; i++)
+            states[i] = AUTOMATON_NONE;
+
+        states[AUTOMATON_BEFORE_FIRST] = AUTOMATON_START;
+        queue[automaton -> size++] = AUTOMATON_BEFORE_FIRST;
+
+        for (uint32_t s = 0; s < automaton -> size; s++)
+        {
+            const AutomatonNode* node = builder.nodes + queue[s];
+
+            automaton -> first[s] = transitions;
+
+            for (uint8_t j = 0; builder.successors[node -> serial][j] >= 0; j++)
+            {
+                const uint8_t serial = builder.successors[node -> serial][j];
+                uint32_t target = builder.children[node -> children + serial];
+
+                if (target == AUTOMATON_NONE)
+                    continue;
+
+                // a path of length moves goes on with its last moves, in the context of the move before them
+                if (builder.nodes[target].level == length)
+                    target = builder.nodes[target].suffix;
+
+                if (states[target] == AUTOMATON_NONE)
+                {
+                    states[target] = automaton -> size;
+                    queue[automaton -> size++] = target;
+                }
+
+                automaton -> serials[transitions] = serial;
+                automaton -> targets[transitions++] = states[target];
+            }
+        }
+
+        automaton -> first[automaton -> size] = transitions;
+        automaton -> nodes = builder.size;
+    }
+
+    failed = failed || !move_automaton_count(automaton, moves_map);
+
+    free(states);
+    free(queue);
+    free(builder.nodes);
+    free(builder.children);
+    free(builder.hash);
+
+    if (failed)
+        move_automaton_free(automaton);
+
+    return !failed;
+}
+
+/**
+ *                       Counts the paths of every length moves_map and an automaton allow.
+ *
+ * Fills sequences and kept, for paths of 1 to AUTOMATON_MAX_LENGTH moves from the start.
+ *
+ * @param automaton             The automaton, with its transitions.
+ * @param moves_map             A 2D array of moves (19 x 19), the one the automaton is built from.
+ *
+ * @return                      False if out of memory.
+ */
+bool move_automaton_count(MoveAutomaton* automaton, const Move* moves_map)
+{
+    const uint8_t moves_size = 19;
+    uint64_t* counts = (uint64_t*)(calloc(2 * (size_t)(automaton -> size) + 1, sizeof(uint64_t)));
+    uint64_t paths[2][19] = {{0}};
+
+    if (counts == NULL)
+        return false;
+
+    // the first moves are the moves whose row allows a second move
+    for (uint8_t i = 0; i < moves_size; i++)
+        paths[0][i] = moves_map[i * moves_size + 1].transform != NULL;
+
+    counts[AUTOMATON_START] = 1;
+
+    for (uint8_t l = 0; l < AUTOMATON_MAX_LENGTH; l++)
+    {
+        uint64_t* current = counts + (l % 2) * automaton -> size;
+        uint64_t* next = counts + (l % 2 == 0) * automaton -> size;
+
+        memset(paths[1], 0, sizeof(paths[1]));
+        memset(next, 0, automaton -> size * sizeof(uint64_t));
+        automaton -> sequences[l] = 0;
+        automaton -> kept[l] = 0;
+
+        for (uint8_t m = 0; m < moves_size; m++)
+        {
+            automaton -> sequences[l] += paths[0][m];
+
+            for (uint8_t j = 1; j < moves_size && moves_map[m * moves_size + j].transform != NULL; j++)
+                paths[1][moves_map[m * moves_size + j].serial] += paths[0][m];
+        }
+
+        for (uint32_t s = 0; s < automaton -> size; s++)
+        {
+            for (uint32_t t = automaton -> first[s]; t < automaton -> first[s + 1]; t++)
+            {
+                next[automaton -> targets[t]] += current[s];
+                automaton -> kept[l] += current[s];
+            }
+        }
+
+        memcpy(paths[0], paths[1], sizeof(paths[1]));
+    }
+
+    free(counts);
+    return true;
+}
+
+/**
+ *                       Frees all the memory allocated by an automaton.
+ *
+ * @param automaton             The automaton to free.
+ */
+void move_automaton_free(MoveAutomaton* automaton)
+{
+    free(automaton -> first);
+    free(automaton -> serials);
+    free(automaton -> targets);
+    free(automaton -> accepting);
+    automaton -> first = NULL;
+    automaton -> serials = NULL;
+    automaton -> targets = NULL;
+    automaton -> accepting = NULL;
+    automaton -> size = 0;
+}
@@ -0,0 +1,173 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "move.h"
+#include "move_bitslice.h"
+
+static bool bitslice_ready = false;
+static uint8_t MOVE_BIT_TARGET[19][32]; // bit k of a packed state goes to bit MOVE_BIT_TARGET[serial][k]
+
+/**
+ *                       Builds the plane permutation of every move.
+ *
+ * Every move only moves bits of the packed state around, this function records where
+ * each bit goes. It is called by the other bitslice functions when needed.
+ */
+void bitslice_init()
+{
+    const Move ALL_MOVES[19] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2};
+
+    if (bitslice_ready)
+        return;
+
+    for (uint8_t i = 0; i < 19; i++)
+    {
+        for (uint8_t k = 0; k < 32; k++)
+            MOVE_BIT_TARGET[i][k] = __builtin_ctz(ALL_MOVES[i].transform(1u << k));
+    }
+
+    bitslice_ready = true;
+}
+
+/**
+ *                       Transposes a 64 x 64 bit matrix in place.
+ *
+ * After the call, bit c of a[r] is the former bit r of a[c]. The matrix is split into
+ * 4 blocks, the two off-diagonal blocks are swapped, then the same is done inside every
+ * block with half the size.
+ *
+ * @param a                     The 64 rows of the matrix.
+ */
+static void transpose64(uint64_t a[64])
+{
+    uint64_t m = 0x00000000ffffffffULL;
+
+    for (uint8_t j = 32; j != 0; j >>= 1, m ^= m << j)
+    {
+        for (uint8_t k = 0; k < 64; k = ((k | j) + 1) & ~j)
+        {
+            const uint64_t t = ((a[k] >> j) ^ a[k | j]) & m;
+
+            a[k | j] ^= t;
+            a[k] ^= t << j;
+        }
+    }
+}
+
+/**
+ *                       Transposes packed states into a bit-sliced batch.
+ *
+ * @param slice                 The slice to fill.
+ * @param states                The packed states, lane i gets states[i].
+ * @param n                     How many states, at most BITSLICE_LANES, the other lanes are zeroed.
+ */
+void bitslice_transpose_in(BitSlice* slice, const uint32_t* states, size_t n)
+{
+    bitslice_init();
+
+    for (uint8_t w = 0; w < BITSLICE_WORDS; w++)
+    {
+        uint64_t rows[64];
+
+        for (uint8_t i = 0; i < 64; i++)
+            rows[i] = w * 64 + i < n ? states[w * 64 + i] : 0;
+
+        transpose64(rows);
+
+        for (uint8_t k = 0; k < 32; k++)
+            slice -> planes[k][w] = rows[k];
+    }
+
+    for (uint8_t k = 0; k < 32; k++)
+        slice -> map[k] = k;
+}
+
+/**
+ *                       Transposes a bit-sliced batch back into packed states.
+ *
+ * @param slice                 The slice to read.
+ * @param states                Where to store the packed states, states[i] gets lane i.
+ * @param n                     How many lanes to read, at most BITSLICE_LANES.
+ */
+void bitslice_transpose_out(const BitSlice* slice, uint32_t* states, size_t n)
+{
+    for (uint8_t w = 0; w < BITSLICE_WORDS && w * 64 < n; w++)
+    {
+        uint64_t rows[64] = {0};
+
+        for (uint8_t k = 0; k < 32; k++)
+            rows[k] = slice -> planes[slice -> map[k]][w];
+
+        transpose64(rows);
+
+        for (uint8_t i = 0; i < 64 && w * 64 + i < n; i++)
+            states[w * 64 + i] = (uint32_t)(rows[i]);
+    }
+}
+
+/**
+ *                       Applies a move to every lane of a slice.
+ *
+ * Only the bit => plane map is rewritten (32 bytes), the planes themselves are never
+ * touched, so the cost does not depend on the number of lanes.
+ *
+ * @param slice                 The slice to transform.
+ * @param serial                The serial of the move (R = 0 ... Dw2 = 18).
+ */
+void bitslice_apply(BitSlice* slice, uint8_t serial)
+{
+    const uint8_t* target = MOVE_BIT_TARGET[serial];
+    uint8_t map[32];
+
+    for (uint8_t k = 0; k < 32; k++)
+        map[target[k]] = slice -> map[k];
+
+    memcpy(slice -> map, map, sizeof(map));
+}
+
+/**
+ *                       Applies a sequence of moves to every lane of a slice.
+ *
+ * @param slice                 The slice to transform.
+ * @param serials               The serials of the moves, in order.
+ * @param size                  How many moves.
+ */
+void bitslice_apply_sequence(BitSlice* slice, const uint8_t* serials, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        bitslice_apply(slice, serials[i]);
+}
+
+/**
+ *                       Checks every lane of a slice against the original states.
+ *
+ * A lane equals an original state when every plane matches the corresponding bit of
+ * that state, which is a chain of and / and-not over the 32 planes.
+ *
+ * @param slice                 The slice to check.
+ * @param original_states       An array of 8 original states to check against.
+ * @param hits                  Where to store the result, bit i % 64 of hits[i / 64] is set if lane i is an original state.
+ */
+void bitslice_original_state(const BitSlice* slice, const int* original_states, uint64_t hits[BITSLICE_WORDS])
+{
+    for (uint8_t w = 0; w < BITSLICE_WORDS; w++)
+    {
+        hits[w] = 0;
+
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            const uint32_t original_state = original_states[i];
+            uint64_t equal = ~0ULL;
+
+            for (uint8_t k = 0; k < 32 && equal != 0; k++)
+            {
+                const uint64_t plane = slice -> planes[slice -> map[k]][w];
+                equal &= (original_state >> k & 1) ? plane : ~plane;
+            }
+
+            hits[w] |= equal;
+        }
+    }
+}
@@ -0,0 +1,553 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "move_canonical.h"
+
+typedef struct canonical_element
+{
+    uint32_t state; // the probe state after the moves
+    uint8_t phases[256]; // phases[p]: the edge phase after the moves from edge phase p
+} CanonicalElement;
+
+typedef struct canonical_class
+{
+    uint8_t size; // how many moves
+    uint8_t moves[19]; // the serials of the moves
+    uint16_t elements; // how many cubes the runs of the class reach
+    uint16_t* next; // next[g * size + i]: the element after moves[i] from element g
+    uint16_t start[19]; // start[i]: the element of moves[i] alone
+    uint8_t entries; // how many distinct sets of moves are allowed before a run
+    uint32_t entry_masks[38]; // bit p is set if move p may come right before the run, bit 19 if the run may start the path
+    uint8_t entry_of[2][19]; // entry_of[tightened][i]: the entry mask of a run starting with moves[i], 0xff if none
+    uint8_t exits; // how many distinct sets of moves are allowed after a run
+    uint32_t exit_masks[19]; // bit s is set if move s may come right after the run
+    uint8_t exit_of[19]; // exit_of[i]: the exit mask of a run ending with moves[i]
+    uint32_t inside[2][19]; // inside[tightened][i]: bit j is set if moves[j] may follow moves[i]
+    size_t words; // how many words a set of runs takes
+} CanonicalClass;
+
+/**
+ *                       Builds the probe state of every position holding its own piece.
+ *
+ * @return                      The probe state.
+ */
+static uint32_t canonical_probe()
+{
+    uint32_t probe = 0;
+
+    for (uint8_t i = 0; i < 8; i++)
+        probe |= (uint32_t)(i) << (29 - 3 * i);
+
+    for (uint8_t i = 0; i < 4; i++)
+        probe |= (uint32_t)(i) << (6 - 2 * i);
+
+    return probe;
+}
+
+/**
+ *                       Checks if two moves commute.
+ *
+ * The moves commute if playing them in either order gives the same packed state and the
+ * same edge phase from any cube. Both only permute the fields of the state, so applying
+ * them to a state with a different piece on every position is enough.
+ *
+ * @param a                     The first move.
+ * @param b                     The second move.
+ *
+ * @return                      True if a then b is always b then a.
+ */
+bool moves_commute(const Move* a, const Move* b)
+{
+    const uint32_t probe = canonical_probe();
+
+    if (a -> transform(b -> transform(probe)) != b -> transform(a -> transform(probe)))
+        return false;
+
+    edge_phase_table_init();
+
+    for (uint16_t phase = 0; phase < 256; phase++)
+    {
+        if (EDGE_PHASE_TABLE[a -> serial][EDGE_PHASE_TABLE[b -> serial][phase]] !=
+            EDGE_PHASE_TABLE[b -> serial][EDGE_PHASE_TABLE[a -> serial][phase]])
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ *                       Finds the cubes the moves of a class reach.
+ *
+ * The moves commute, so the cube of a run only depends on how many times each move is
+ * played, and the runs reach a small group of cubes. Every cube is numbered, and the
+ * number after every move is kept.
+ *
+ * @param cls                   The class, with its moves.
+ *
+ * @return                      True if built, false if out of memory or more than CANONICAL_ELEMENTS cubes.
+ */
+static bool canonical_elements(CanonicalClass* cls)
+{
+    const Move ALL_MOVES[19] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2};
+    CanonicalElement* elements = (CanonicalElement*)(malloc(CANONICAL_ELEMENTS * sizeof(CanonicalElement)));
+
+    cls -> next = (uint16_t*)(malloc(CANONICAL_ELEMENTS * cls -> size * sizeof(uint16_t)));
+
+    if (elements == NULL || cls -> next == NULL)
+    {
+        free(elements);
+        return false;
+    }
+
+    elements[0].state = canonical_probe();
+
+    for (uint16_t p = 0; p < 256; p++)
+        elements[0].phases[p] = p;
+
+    cls -> elements = 1;
+
+    // breadth-first from the solved cube, the list grows while it is walked
+    for (uint16_t g = 0; g < cls -> elements; g++)
+    {
+        for (uint8_t i = 0; i < cls -> size; i++)
+        {
+            const uint8_t serial = cls -> moves[i];
+            CanonicalElement element;
+            uint16_t found = 0;
+
+            element.state = ALL_MOVES[serial].transform(elements[g].state);
+
+            for (uint16_t p = 0; p < 256; p++)
+                element.phases[p] = EDGE_PHASE_TABLE[serial][elements[g].phases[p]];
+
+            while (found < cls -> elements && (elements[found].state != element.state ||
+                                               memcmp(elements[found].phases, element.phases, 256) != 0))
+                found++;
+
+            if (found == cls -> elements)
+            {
+                if (cls -> elements == CANONICAL_ELEMENTS)
+                {
+                    free(elements);
+                    return false;
+                }
+
+                elements[cls -> elements++] = element;
+            }
+
+            cls -> next[g * cls -> size + i] = found;
+
+            if (g == 0)
+                cls -> start[i] = found;
+        }
+    }
+
+    free(elements);
+    return true;
+}
+
+/**
+ *                       Finds the index of a mask in a list, appending it if missing.
+ *
+ * @param masks                 The list.
+ * @param size                  How many masks the list holds.
+ * @param mask                  The mask.
+ *
+ * @return                      The index of the mask.
+ */
+static uint8_t canonical_mask_index(uint32_t* masks, uint8_t* size, uint32_t mask)
+{
+    for (uint8_t i = 0; i < *size; i++)
+    {
+        if (masks[i] == mask)
+            return i;
+    }
+
+    masks[*size] = mask;
+    return (*size)++;
+}
+
+/**
+ *                       Builds the entry masks of the runs of a class.
+ *
+ * @param cls                   The class.
+ * @param successors            successors[m]: bit s is set if move s may follow move m, in the original moves_map.
+ * @param tightened             tightened[m]: the same in the tightened moves_map.
+ */
+static void canonical_entries(CanonicalClass* cls, const uint32_t* successors, const uint32_t* tightened)
+{
+    uint32_t members = 0;
+
+    cls -> entries = 0;
+
+    for (uint8_t i = 0; i < cls -> size; i++)
+        members |= 1u << cls -> moves[i];
+
+    for (uint8_t side = 0; side < 2; side++)
+    {
+        const uint32_t* rows = side == 0 ? successors : tightened;
+
+        for (uint8_t i = 0; i < cls -> size; i++)
+        {
+            uint32_t mask = rows[cls -> moves[i]] != 0 ? 1u << 19 : 0;
+
+            for (uint8_t p = 0; p < 19; p++)
+            {
+                if (!(members >> p & 1) && (rows[p] >> cls -> moves[i] & 1))
+                    mask |= 1u << p;
+            }
+
+            cls -> entry_of[side][i] = mask == 0 ? 0xff : canonical_mask_index(cls -> entry_masks, &cls -> entries, mask);
+        }
+    }
+}
+
+/**
+ *                       Starts the runs of one move.
+ *
+ * A run is stored as a bit of (entry mask, last move, element).
+ *
+ * @param cls                   The class.
+ * @param side                  0 for the original moves_map, 1 for the tightened one.
+ * @param runs                  The set of runs, cls -> words words.
+ */
+static void canonical_first(const CanonicalClass* cls, uint8_t side, uint64_t* runs)
+{
+    memset(runs, 0, cls -> words * sizeof(uint64_t));
+
+    for (uint8_t i = 0; i < cls -> size; i++)
+    {
+        if (cls -> entry_of[side][i] == 0xff)
+            continue;
+
+        const size_t bit = ((size_t)(cls -> entry_of[side][i]) * cls -> size + i) * cls -> elements + cls -> start[i];
+
+        runs[bit / 64] |= 1ull << (bit % 64);
+    }
+}
+
+/**
+ *                       Extends every run by one move.
+ *
+ * @param cls                   The class.
+ * @param side                  0 for the original moves_map, 1 for the tightened one.
+ * @param from                  The runs of a length.
+ * @param to                    The runs one move longer.
+ */
+static void canonical_step(const CanonicalClass* cls, uint8_t side, const uint64_t* from, uint64_t* to)
+{
+    memset(to, 0, cls -> words * sizeof(uint64_t));
+
+    for (size_t w = 0; w < cls -> words; w++)
+    {
+        for (uint64_t bits = from[w]; bits != 0; bits &= bits - 1)
+        {
+            const size_t run = w * 64 + __builtin_ctzll(bits);
+            const uint16_t g = run % cls -> elements;
+            const uint8_t last = run / cls -> elements % cls -> size;
+            const size_t entry = run / cls -> elements / cls -> size;
+
+            for (uint32_t inside = cls -> inside[side][last]; inside != 0; inside &= inside - 1)
+            {
+                const uint8_t i = __builtin_ctz(inside);
+                const size_t bit = (entry * cls -> size + i) * cls -> elements + cls -> next[g * cls -> size + i];
+
+                to[bit / 64] |= 1ull << (bit % 64);
+            }
+        }
+    }
+}
+
+/**
+ *                       Checks if the tightened runs of a length match the original ones.
+ *
+ * A run is matched by a run with the same element, allowed after at least the same moves
+ * and followed by at least the same moves.
+ *
+ * @param cls                   The class.
+ * @param original              The original runs.
+ * @param tightened             The tightened runs.
+ * @param reached               A buffer of entries x exits x elements bytes.
+ *
+ * @return                      True if every original run is matched.
+ */
+static bool canonical_matched(const CanonicalClass* cls, const uint64_t* original, const uint64_t* tightened, uint8_t* reached)
+{
+    const size_t size = (size_t)(cls -> entries) * cls -> exits * cls -> elements;
+
+    memset(reached, 0, size);
+
+    for (size_t w = 0; w < cls -> words; w++)
+    {
+        for (uint64_t bits = tightened[w]; bits != 0; bits &= bits - 1)
+        {
+            const size_t run = w * 64 + __builtin_ctzll(bits);
+            const uint8_t last = run / cls -> elements % cls -> size;
+            const size_t entry = run / cls -> elements / cls -> size;
+
+            reached[(entry * cls -> exits + cls -> exit_of[last]) * cls -> elements + run % cls -> elements] = 1;
+        }
+    }
+
+    for (size_t w = 0; w < cls -> words; w++)
+    {
+        for (uint64_t bits = original[w]; bits != 0; bits &= bits - 1)
+        {
+            const size_t run = w * 64 + __builtin_ctzll(bits);
+            const uint16_t g = run % cls -> elements;
+            const uint32_t entry_mask = cls -> entry_masks[run / cls -> elements / cls -> size];
+            const uint32_t exit_mask = cls -> exit_masks[cls -> exit_of[run / cls -> elements % cls -> size]];
+            bool matched = false;
+
+            for (uint8_t e = 0; e < cls -> entries && !matched; e++)
+            {
+                if ((entry_mask & ~cls -> entry_masks[e]) != 0)
+                    continue;
+
+                for (uint8_t x = 0; x < cls -> exits && !matched; x++)
+                    matched = (exit_mask & ~cls -> exit_masks[x]) == 0 && reached[((size_t)(e) * cls -> exits + x) * cls -> elements + g];
+            }
+
+            if (!matched)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ *                       Checks if a tightened moves map keeps every run of a class.
+ *
+ * The runs of both moves maps are extended one move at a time until the pair of sets
+ * repeats, no original run is left, or CANONICAL_MAX_LENGTH moves.
+ *
+ * @param cls                   The class, with its inside masks.
+ * @param history               A buffer of 2 x CANONICAL_MAX_LENGTH sets of runs.
+ * @param reached               A buffer of entries x exits x elements bytes.
+ *
+ * @return                      True if every run of every length is matched.
+ */
+static bool canonical_covered(const CanonicalClass* cls, uint64_t* history, uint8_t* reached)
+{
+    const size_t words = cls -> words;
+
+    canonical_first(cls, 0, history);
+    canonical_first(cls, 1, history + words);
+
+    for (uint8_t n = 0; n < CANONICAL_MAX_LENGTH; n++)
+    {
+        uint64_t* original = history + 2 * n * words;
+        uint64_t* tightened = original + words;
+        bool empty = true;
+
+        if (!canonical_matched(cls, original, tightened, reached))
+            return false;
+
+        for (size_t w = 0; w < words && empty; w++)
+            empty = original[w] == 0;
+
+        if (empty)
+            return true;
+
+        // the next sets only depend on these ones, a repeated pair repeats what follows it
+        for (uint8_t m = 0; m < n; m++)
+        {
+            if (memcmp(history + 2 * m * words, original, 2 * words * sizeof(uint64_t)) == 0)
+                return true;
+        }
+
+        if (n + 1 < CANONICAL_MAX_LENGTH)
+        {
+            canonical_step(cls, 0, original, tightened + words);
+            canonical_step(cls, 1, tightened, tightened + 2 * words);
+        }
+    }
+
+    return true;
+}
+
+/**
+ *                       Tightens the rows of the moves of one class.
+ *
+ * @param cls                   The class, with its moves.
+ * @param successors            successors[m]: bit s is set if move s may follow move m, in the original moves_map.
+ * @param tightened             The same, tightened in place.
+ * @param stats                 Where to count the successors.
+ *
+ * @return                      False if out of memory.
+ */
+static bool canonical_class(CanonicalClass* cls, const uint32_t* successors, uint32_t* tightened, CanonicalStats* stats)
+{
+    if (!canonical_elements(cls))
+    {
+        free(cls -> next);
+
+        // too many cubes to compare the runs, the class is left as it is
+        return true;
+    }
+
+    uint32_t members = 0;
+
+    for (uint8_t i = 0; i < cls -> size; i++)
+        members |= 1u << cls -> moves[i];
+
+    cls -> exits = 0;
+
+    for (uint8_t i = 0; i < cls -> size; i++)
+    {
+        cls -> exit_of[i] = canonical_mask_index(cls -> exit_masks, &cls -> exits, successors[cls -> moves[i]] & ~members);
+        cls -> inside[0][i] = cls -> inside[1][i] = 0;
+
+        for (uint8_t j = 0; j < cls -> size; j++)
+        {
+            if (successors[cls -> moves[i]] >> cls -> moves[j] & 1)
+                cls -> inside[0][i] |= cls -> inside[1][i] |= 1u << j;
+        }
+    }
+
+    // the entry masks of both sides fit in 2 x size distinct masks
+    cls -> words = ((size_t)(2 * cls -> size) * cls -> size * cls -> elements + 63) / 64;
+
+    uint64_t* history = (uint64_t*)(malloc(2 * CANONICAL_MAX_LENGTH * cls -> words * sizeof(uint64_t)));
+    uint8_t* reached = (uint8_t*)(malloc((size_t)(2 * cls -> size) * cls -> size * cls -> elements));
+
+    if (history == NULL || reached == NULL)
+    {
+        free(history);
+        free(reached);
+        free(cls -> next);
+        return false;
+    }
+
+    // the highest moves first, so "D U" is tried before "U D" would be
+    for (int8_t high = cls -> size - 1; high >= 0; high--)
+    {
+        for (int8_t low = high - 1; low >= 0; low--)
+        {
+            const uint8_t high_serial = cls -> moves[high];
+            const uint8_t low_serial = cls -> moves[low];
+
+            if (!(successors[high_serial] >> low_serial & 1))
+                continue;
+
+            if (successors[low_serial] >> high_serial & 1)
+                stats -> both_orders++;
+
+            tightened[high_serial] &= ~(1u << low_serial);
+            cls -> inside[1][high] &= ~(1u << low);
+            canonical_entries(cls, successors, tightened);
+
+            if (canonical_covered(cls, history, reached))
+                stats -> removed++;
+            else
+            {
+                tightened[high_serial] |= 1u << low_serial;
+                cls -> inside[1][high] |= 1u << low;
+            }
+        }
+    }
+
+    free(history);
+    free(reached);
+    free(cls -> next);
+    return true;
+}
+
+/**
+ *                       Tightens a moves map to one ordering of commuting moves.
+ *
+ * The moves are split into classes of moves that all commute with each other, and every
+ * path into runs of moves of one class. A run only counts by its length, by the cube it
+ * reaches, by the moves allowed before its first move and by the moves allowed after its
+ * last one: any other run that matches them can replace it in a path.
+ *
+ * The successors of a move that have a lower serial and are in its class are tried in
+ * turn: one is removed if every run of the original moves_map is still matched by a run of
+ * the tightened one. Orders like "D U" go first, so the ascending order of every commuting
+ * block is the one kept when both are allowed. Every cube keeps a path of every length it
+ * had, so the shortest solution length does not change, while the searches skip the runs
+ * that only repeat another one.
+ *
+ * @param moves_map             A 2D array of moves (19 x 19), as given to the solvers. The rows are compacted in place.
+ * @param stats                 Where to store the classes and count the removed successors, or NULL.
+ *
+ * @return                      How many successors are removed, 0 if out of memory.
+ */
+uint16_t moves_map_canonical(Move* moves_map, CanonicalStats* stats)
+{
+    const Move ALL_MOVES[19] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2};
+    CanonicalStats counts = {0};
+    uint32_t commute[19] = {0}; // bit m is set if the move commutes with move m
+    uint32_t successors[19] = {0}; // bit m is set if move m may follow the move, in the original moves_map
+    uint32_t tightened[19] = {0};
+    bool out_of_memory = false;
+
+    memset(counts.class_of, 0xff, sizeof(counts.class_of));
+
+    for (uint8_t i = 0; i < 19; i++)
+    {
+        for (uint8_t j = 1; j < 19 && moves_map[i * 19 + j].transform != NULL; j++)
+            successors[i] |= 1u << moves_map[i * 19 + j].serial;
+
+        tightened[i] = successors[i];
+
+        for (uint8_t j = 0; j < 19; j++)
+        {
+            if (j != i && moves_commute(ALL_MOVES + i, ALL_MOVES + j))
+                commute[i] |= 1u << j;
+        }
+    }
+
+    for (uint8_t i = 0; i < 19 && !out_of_memory; i++)
+    {
+        if (commute[i] == 0 || counts.class_of[i] != 0xff)
+            continue;
+
+        // a class is the move and the moves it commutes with, if they all commute with each other
+        const uint32_t members = commute[i] | 1u << i;
+        CanonicalClass cls = {0};
+        bool clique = true;
+
+        for (uint8_t j = 0; j < 19; j++)
+        {
+            if (members >> j & 1)
+            {
+                clique &= (commute[j] | 1u << j) == members;
+                cls.moves[cls.size++] = j;
+            }
+        }
+
+        if (!clique)
+            continue;
+
+        for (uint8_t j = 0; j < cls.size; j++)
+            counts.class_of[cls.moves[j]] = counts.classes;
+
+        counts.classes++;
+        out_of_memory = !canonical_class(&cls, successors, tightened, &counts);
+    }
+
+    if (out_of_memory)
+        counts.removed = 0;
+
+    for (uint8_t i = 0; i < 19 && counts.removed > 0; i++)
+    {
+        uint8_t size = 1;
+
+        for (uint8_t j = 1; j < 19 && moves_map[i * 19 + j].transform != NULL; j++)
+        {
+            if (tightened[i] >> moves_map[i * 19 + j].serial & 1)
+                moves_map[i * 19 + size++] = moves_map[i * 19 + j];
+        }
+
+        for (uint8_t j = size; j < 19; j++)
+            moves_map[i * 19 + j] = EMPTY;
+    }
+
+    if (stats != NULL)
+        *stats = counts;
+
+    return counts.removed;
+}
@@ -0,0 +1,822 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "move_constraint.h"
+
+#define CONSTRAINT_ALL_MOVES 0x7ffffu // every move, bit m for serial m
+#define CONSTRAINT_WORDS (CONSTRAINT_MAX_NFA / 64) // the words of a set of NFA states
+
+typedef struct constraint_nfa_state
+{
+    uint32_t moves; // the moves of the transition to out[0], 0 for an epsilon state
+    int16_t out[2]; // the next states, -1 if none
+} ConstraintNfaState;
+
+typedef struct constraint_fragment
+{
+    int16_t start; // -1 if the fragment could not be parsed
+    int16_t end; // an epsilon state without next states yet
+} ConstraintFragment;
+
+typedef struct constraint_parser
+{
+    const char* pattern;
+    const char* cursor;
+    ConstraintNfaState states[CONSTRAINT_MAX_NFA];
+    uint16_t size;
+    char* error; // 128 bytes, set at the first error
+    bool failed;
+} ConstraintParser;
+
+static ConstraintFragment constraint_parse_alternation(ConstraintParser* parser);
+
+/**
+ *                       Records the first error of a parser.
+ *
+ * @param parser                The parser.
+ * @param message               What is wrong, the position of the cursor is appended.
+ */
+static void constraint_fail(ConstraintParser* parser, const char* message)
+{
+    if (!parser -> failed)
+        snprintf(parser -> error, 128, "%s at position %d", message, (int)(parser -> cursor - parser -> pattern));
+
+    parser -> failed = true;
+}
+
+/**
+ *                       Adds a state to the NFA of a parser.
+ *
+ * @param parser                The parser.
+ * @param moves                 The moves of the transition to out0, 0 for an epsilon state.
+ * @param out0                  The first next state, or -1.
+ * @param out1                  The second next state (epsilon states only), or -1.
+ *
+ * @return                      The index of the state, -1 if the NFA is full.
+ */
+static int16_t constraint_state(ConstraintParser* parser, uint32_t moves, int16_t out0, int16_t out1)
+{
+    if (parser -> size == CONSTRAINT_MAX_NFA)
+    {
+        constraint_fail(parser, "pattern too long");
+        return -1;
+    }
+
+    parser -> states[parser -> size] = (ConstraintNfaState){moves, {out0, out1}};
+    return parser -> size++;
+}
+
+/**
+ *                       Builds a fragment that matches one move of a set.
+ *
+ * @param parser                The parser.
+ * @param moves                 The moves matched, or 0 to match no move (the empty sequence).
+ *
+ * @return                      The fragment.
+ */
+static ConstraintFragment constraint_fragment(ConstraintParser* parser, uint32_t moves)
+{
+    const int16_t end = constraint_state(parser, 0, -1, -1);
+    const int16_t start = end < 0 || moves == 0 ? end : constraint_state(parser, moves, end, -1);
+
+    return (ConstraintFragment){start, end};
+}
+
+/**
+ *                       Skips the spaces of a pattern.
+ *
+ * @param parser                The parser.
+ */
+static void constraint_skip(ConstraintParser* parser)
+{
+    while (*parser -> cursor == ' ' || *parser -> cursor == '\t')
+        parser -> cursor++;
+}
+
+/**
+ *                       Reads a move symbol.
+ *
+ * The longest symbol is taken, so "U2" is one move and "RU" two.
+ *
+ * @param parser                The parser, the cursor is moved after the symbol.
+ *
+ * @return                      The bit of the move, 0 if there is no symbol at the cursor.
+ */
+static uint32_t constraint_symbol(ConstraintParser* parser)
+{
+    const Move ALL_MOVES[19] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2};
+    uint8_t best = 19;
+    size_t best_size = 0;
+
+    for (uint8_t i = 0; i < 19; i++)
+    {
+        const size_t size = strlen(ALL_MOVES[i].symbol);
+
+        if (size > best_size && strncmp(parser -> cursor, ALL_MOVES[i].symbol, size) == 0)
+        {
+            best = i;
+            best_size = size;
+        }
+    }
+
+    if (best == 19)
+        return 0;
+
+    parser -> cursor += best_size;
+    return 1u << ALL_MOVES[best].serial;
+}
+
+/**
+ *                       Parses an atom: a move, '.', a set of moves or a group.
+ *
+ * @param parser                The parser.
+ *
+ * @return                      The fragment of the atom.
+ */
+static ConstraintFragment constraint_parse_atom(ConstraintParser* parser)
+{
+    const ConstraintFragment invalid = {-1, -1};
+
+    constraint_skip(parser);
+
+    if (*parser -> cursor == '(')
+    {
+        parser -> cursor++;
+
+        const ConstraintFragment group = constraint_parse_alternation(parser);
+
+        constraint_skip(parser);
+
+        if (*parser -> cursor != ')')
+        {
+            constraint_fail(parser, "missing ')'");
+            return invalid;
+        }
+
+        parser -> cursor++;
+        return group;
+    }
+
+    if (*parser -> cursor == '.')
+    {
+        parser -> cursor++;
+        return constraint_fragment(parser, CONSTRAINT_ALL_MOVES);
+    }
+
+    if (*parser -> cursor == '[')
+    {
+        uint32_t moves = 0;
+        bool complement = false;
+
+        parser -> cursor++;
+        constraint_skip(parser);
+
+        if (*parser -> cursor == '^')
+        {
+            complement = true;
+            parser -> cursor++;
+        }
+
+        for (constraint_skip(parser); *parser -> cursor != ']'; constraint_skip(parser))
+        {
+            const uint32_t move = constraint_symbol(parser);
+
+            if (move == 0)
+            {
+                constraint_fail(parser, *parser -> cursor == '\0' ? "missing ']'" : "unknown move in set");
+                return invalid;
+            }
+
+            moves |= move;
+        }
+
+        parser -> cursor++;
+
+        if (complement)
+            moves = ~moves & CONSTRAINT_ALL_MOVES;
+
+        if (moves == 0)
+        {
+            constraint_fail(parser, "empty set");
+            return invalid;
+        }
+
+        return constraint_fragment(parser, moves);
+    }
+
+    const uint32_t move = constraint_symbol(parser);
+
+    if (move == 0)
+    {
+        constraint_fail(parser, *parser -> cursor == '\0' ? "unexpected end" : "unexpected character");
+        return invalid;
+    }
+
+    return constraint_fragment(parser, move);
+}
+
+/**
+ *                       Joins two fragments, the first one then the second one.
+ *
+ * @param parser                The parser.
+ * @param a                     The first fragment.
+ * @param b                     The second fragment.
+ *
+ * @return                      The fragment of both.
+ */
+static ConstraintFragment constraint_concat(ConstraintParser* parser, ConstraintFragment a, ConstraintFragment b)
+{
+    if (a.start < 0 || b.start < 0)
+        return (ConstraintFragment){-1, -1};
+
+    parser -> states[a.end].out[0] = b.start;
+    return (ConstraintFragment){a.start, b.end};
+}
+
+/**
+ *                       Makes a fragment optional.
+ *
+ * @param parser                The parser.
+ * @param a                     The fragment.
+ * @param repeat                True to also let it repeat ('*'), false to match it at most once ('?').
+ *
+ * @return                      The new fragment.
+ */
+static ConstraintFragment constraint_optional(ConstraintParser* parser, ConstraintFragment a, bool repeat)
+{
+    const int16_t end = a.start < 0 ? -1 : constraint_state(parser, 0, -1, -1);
+    const int16_t start = end < 0 ? -1 : constraint_state(parser, 0, a.start, end);
+
+    if (start < 0)
+        return (ConstraintFragment){-1, -1};
+
+    parser -> states[a.end].out[0] = repeat ? a.start : end;
+    parser -> states[a.end].out[1] = repeat ? end : -1;
+
+    return (ConstraintFragment){start, end};
+}
+
+/**
+ *                       Parses an atom and its repetition, if any.
+ *
+ * A {n,m} repetition parses the atom again for every copy.
+ *
+ * @param parser                The parser.
+ *
+ * @return                      The fragment.
+ */
+static ConstraintFragment constraint_parse_repeat(ConstraintParser* parser)
+{
+    const char* begin = parser -> cursor;
+    ConstraintFragment atom = constraint_parse_atom(parser);
+
+    constraint_skip(parser);
+
+    switch (*parser -> cursor)
+    {
+        case '*':
+        case '?':
+            return constraint_optional(parser, atom, *parser -> cursor++ == '*');
+
+        case '+':
+        {
+            // the end of the atom goes back to its start
+            const int16_t end = atom.start < 0 ? -1 : constraint_state(parser, 0, -1, -1);
+
+            parser -> cursor++;
+
+            if (end < 0)
+                return (ConstraintFragment){-1, -1};
+
+            parser -> states[atom.end].out[0] = atom.start;
+            parser -> states[atom.end].out[1] = end;
+            return (ConstraintFragment){atom.start, end};
+        }
+
+        case '{':
+            break;
+
+        default:
+            return atom;
+    }
+
+    // {n}, {n,} or {n,m}
+    char* end = NULL;
+    const long low = strtol(parser -> cursor + 1, &end, 10);
+    long high = low;
+
+    if (end == parser -> cursor + 1)
+    {
+        constraint_fail(parser, "missing count");
+        return (ConstraintFragment){-1, -1};
+    }
+
+    if (*end == ',')
+        high = end[1] == '}' ? -1 : strtol(end + 1, &end, 10);
+
+    if (*end == ',')
+        end++;
+
+    if (*end != '}' || low < 0 || low > CONSTRAINT_MAX_REPEAT || high > CONSTRAINT_MAX_REPEAT || (high >= 0 && high < low))
+    {
+        constraint_fail(parser, "invalid count");
+        return (ConstraintFragment){-1, -1};
+    }
+
+    const char* after = end + 1;
+    ConstraintFragment result = constraint_fragment(parser, 0);
+
+    // the atom already parsed is the first copy
+    for (long i = 0; i < (high < 0 ? low + 1 : high) && result.start >= 0; i++)
+    {
+        ConstraintFragment copy = atom;
+
+        if (i > 0)
+        {
+            parser -> cursor = begin;
+            copy = constraint_parse_atom(parser);
+        }
+
+        result = constraint_concat(parser, result, i < low ? copy : constraint_optional(parser, copy, high < 0));
+    }
+
+    parser -> cursor = after;
+    return result;
+}
+
+/**
+ *                       Parses a sequence of repeated atoms.
+ *
+ * @param parser                The parser.
+ *
+ * @return                      The fragment, the empty sequence if there is no atom.
+ */
+static ConstraintFragment constraint_parse_sequence(ConstraintParser* parser)
+{
+    ConstraintFragment sequence = constraint_fragment(parser, 0);
+
+    for (constraint_skip(parser); *parser -> cursor != '\0' && *parser -> cursor != '|' && *parser -> cursor != ')' &&
+         !parser -> failed; constraint_skip(parser))
+        sequence = constraint_concat(parser, sequence, constraint_parse_repeat(parser));
+
+    return sequence;
+}
+
+/**
+ *                       Parses sequences separated by '|'.
+ *
+ * @param parser                The parser.
+ *
+ * @return                      The fragment that matches any of them.
+ */
+static ConstraintFragment constraint_parse_alternation(ConstraintParser* parser)
+{
+    ConstraintFragment alternation = constraint_parse_sequence(parser);
+
+    while (*parser -> cursor == '|' && !parser -> failed)
+    {
+        parser -> cursor++;
+
+        const ConstraintFragment other = constraint_parse_sequence(parser);
+        const int16_t end = other.start < 0 || alternation.start < 0 ? -1 : constraint_state(parser, 0, -1, -1);
+        const int16_t start = end < 0 ? -1 : constraint_state(parser, 0, alternation.start, other.start);
+
+        if (start < 0)
+            return (ConstraintFragment){-1, -1};
+
+        parser -> states[alternation.end].out[0] = end;
+        parser -> states[other.end].out[0] = end;
+        alternation = (ConstraintFragment){start, end};
+    }
+
+    return alternation;
+}
+
+/**
+ *                       Adds the states reached by epsilon transitions to a set of NFA states.
+ *
+ * @param parser                The parser, with the NFA.
+ * @param set                   The set, CONSTRAINT_WORDS words.
+ */
+static void constraint_closure(const ConstraintParser* parser, uint64_t* set)
+{
+    int16_t stack[CONSTRAINT_MAX_NFA];
+    uint16_t size = 0;
+
+    for (uint16_t i = 0; i < parser -> size; i++)
+    {
+        if (set[i / 64] >> (i % 64) & 1)
+            stack[size++] = i;
+    }
+
+    while (size > 0)
+    {
+        const ConstraintNfaState* state = parser -> states + stack[--size];
+
+        for (uint8_t k = 0; k < 2 && state -> moves == 0; k++)
+        {
+            const int16_t out = state -> out[k];
+
+            if (out >= 0 && !(set[out / 64] >> (out % 64) & 1))
+            {
+                set[out / 64] |= 1ull << (out % 64);
+                stack[size++] = out;
+            }
+        }
+    }
+}
+
+/**
+ *                       Compiles a pattern over move symbols.
+ *
+ * A pattern matches whole solutions. It is made of move symbols (R, U', Dw2, ...), '.' for
+ * any move, sets of moves like [U U' U2] or [^F], groups in parentheses, the alternation
+ * '|' and the repetitions '*', '+', '?', '{n}', '{n,}' and '{n,m}'. Spaces are ignored,
+ * "R U" and "RU" are the same. A leading '!' negates the pattern. For example ".* R" only
+ * lets the solutions that end with R through, "!(.* F){3} .*" the ones with at most two F,
+ * and "[U U' U2] .*" the ones that start with a U turn.
+ *
+ * The pattern is compiled into a deterministic automaton over the 19 moves, every state
+ * of which has a transition for every move.
+ *
+ * @param constraint            The constraint to build.
+ * @param pattern               The pattern.
+ * @param error                 Where to write why the pattern is invalid, 128 bytes.
+ *
+ * @return                      True if compiled, false if invalid or out of memory.
+ */
+bool move_constraint_compile(MoveConstraint* constraint, const char* pattern, char* error)
+{
+    ConstraintParser* parser = (ConstraintParser*)(calloc(1, sizeof(ConstraintParser)));
+
+    memset(constraint, 0, sizeof(MoveConstraint));
+
+    if (parser == NULL)
+    {
+        snprintf(error, 128, "out of memory");
+        return false;
+    }
+
+    parser -> pattern = pattern;
+    parser -> cursor = pattern;
+    parser -> error = error;
+    constraint_skip(parser);
+
+    if (*parser -> cursor == '!')
+    {
+        constraint -> negated = true;
+        parser -> cursor++;
+    }
+
+    const ConstraintFragment nfa = constraint_parse_alternation(parser);
+
+    if (!parser -> failed && *parser -> cursor != '\0')
+        constraint_fail(parser, "unmatched ')'");
+
+    if (parser -> failed || nfa.start < 0)
+    {
+        constraint_fail(parser, "invalid pattern");
+        free(parser);
+        return false;
+    }
+
+    // subset construction, every state of the automaton is a set of NFA states, the empty set included
+    uint64_t* sets = (uint64_t*)(malloc(CONSTRAINT_MAX_STATES * CONSTRAINT_WORDS * sizeof(uint64_t)));
+
+    constraint -> next = (int16_t*)(malloc(CONSTRAINT_MAX_STATES * 19 * sizeof(int16_t)));
+    constraint -> accepting = (bool*)(malloc(CONSTRAINT_MAX_STATES * sizeof(bool)));
+
+    if (sets == NULL || constraint -> next == NULL || constraint -> accepting == NULL)
+    {
+        snprintf(error, 128, "out of memory");
+        free(sets);
+        free(parser);
+        move_constraint_free(constraint);
+        return false;
+    }
+
+    memset(sets, 0, CONSTRAINT_WORDS * sizeof(uint64_t));
+    sets[nfa.start / 64] |= 1ull << (nfa.start % 64);
+    constraint_closure(parser, sets);
+    constraint -> size = 1;
+
+    bool failed = false;
+
+    for (uint16_t s = 0; s < constraint -> size && !failed; s++)
+    {
+        constraint -> accepting[s] = (sets[s * CONSTRAINT_WORDS + nfa.end / 64] >> (nfa.end % 64) & 1) != constraint -> negated;
+
+        for (uint8_t m = 0; m < 19 && !failed; m++)
+        {
+            uint64_t next[CONSTRAINT_WORDS] = {0};
+
+            for (uint16_t i = 0; i < parser -> size; i++)
+            {
+                const ConstraintNfaState* state = parser -> states + i;
+
+                if ((sets[s * CONSTRAINT_WORDS + i / 64] >> (i % 64) & 1) && (state -> moves >> m & 1))
+                    next[state -> out[0] / 64] |= 1ull << (state -> out[0] % 64);
+            }
+
+            constraint_closure(parser, next);
+
+            uint16_t t = 0;
+
+            while (t < constraint -> size && memcmp(sets + t * CONSTRAINT_WORDS, next, sizeof(next)) != 0)
+                t++;
+
+            if (t == constraint -> size)
+            {
+                if (constraint -> size == CONSTRAINT_MAX_STATES)
+                {
+                    snprintf(error, 128, "pattern too complex, more than %d states", CONSTRAINT_MAX_STATES);
+                    failed = true;
+                    break;
+                }
+
+                memcpy(sets + t * CONSTRAINT_WORDS, next, sizeof(next));
+                constraint -> size++;
+            }
+
+            constraint -> next[s * 19 + m] = t;
+        }
+    }
+
+    free(sets);
+    free(parser);
+
+    if (failed)
+        move_constraint_free(constraint);
+
+    return !failed;
+}
+
+/**
+ *                       Frees all the memory allocated by a constraint.
+ *
+ * @param constraint            The constraint to free.
+ */
+void move_constraint_free(MoveConstraint* constraint)
+{
+    free(constraint -> next);
+    free(constraint -> accepting);
+    constraint -> next = NULL;
+    constraint -> accepting = NULL;
+    constraint -> size = 0;
+}
+
+/**
+ *                       Builds the product of moves_map and constraints.
+ *
+ * The states of the product are a last move (or the start of the path) and a state of
+ * every constraint. A state is accepting if every constraint accepts, and the states from
+ * which no accepting state can be reached are removed with the transitions into them, so
+ * a search stepping the product never enters a branch without a solution allowed by the
+ * constraints. The transitions keep the moves_map order.
+ *
+ * @param automaton             The automaton to build, its accepting array is set.
+ * @param moves_map             A 2D array of moves (19 x 19), as given to the solvers.
+ * @param constraints           The compiled constraints.
+ * @param size                  How many constraints, 1 to CONSTRAINT_MAX_SIZE.
+ *
+ * @return                      True if built, false if out of memory or more than CONSTRAINT_MAX_PRODUCT states.
+ */
+bool move_automaton_constrain(MoveAutomaton* automaton, const Move* moves_map, const MoveConstraint* constraints, uint8_t size)
+{
+    const uint8_t moves_size = 19;
+    const uint8_t width = size + 1; // a tuple is the last move, then the state of every constraint
+    const uint32_t hash_capacity = 2 * CONSTRAINT_MAX_PRODUCT;
+
+    memset(automaton, 0, sizeof(MoveAutomaton));
+
+    for (uint8_t i = 0; i < moves_size; i++)
+        automaton -> moves[i] = EMPTY;
+
+    for (uint16_t i = 0; i < moves_size * moves_size; i++)
+    {
+        if (moves_map[i].transform != NULL)
+            automaton -> moves[moves_map[i].serial] = moves_map[i];
+    }
+
+    // the moves allowed after every move, and the first moves after the last row
+    int8_t successors[20][20];
+    uint8_t first_size = 0;
+
+    for (uint8_t i = 0; i < moves_size; i++)
+    {
+        uint8_t count = 0;
+
+        for (uint8_t j = 1; j < moves_size && moves_map[i * moves_size + j].transform != NULL; j++)
+            successors[i][count++] = moves_map[i * moves_size + j].serial;
+
+        successors[i][count] = -1;
+
+        if (count != 0)
+            successors[moves_size][first_size++] = i;
+    }
+
+    successors[moves_size][first_size] = -1;
+
+    uint16_t* tuples = (uint16_t*)(malloc((size_t)(CONSTRAINT_MAX_PRODUCT) * width * sizeof(uint16_t)));
+    uint32_t* hash = (uint32_t*)(calloc(hash_capacity, sizeof(uint32_t)));
+    uint32_t* first = (uint32_t*)(malloc((CONSTRAINT_MAX_PRODUCT + 1) * sizeof(uint32_t)));
+    uint8_t* serials = NULL;
+    uint32_t* targets = NULL;
+    uint32_t transitions = 0;
+    uint32_t capacity = 0;
+    uint32_t states = 1;
+    bool failed = tuples == NULL || hash == NULL || first == NULL;
+
+    // the start: before the first move, every constraint at its start state
+    for (uint8_t i = 0; i < width && !failed; i++)
+        tuples[i] = i == 0 ? moves_size : 0;
+
+    for (uint32_t s = 0; s < states && !failed; s++)
+    {
+        const uint16_t* tuple = tuples + (size_t)(s) * width;
+
+        first[s] = transitions;
+
+        for (uint8_t j = 0; successors[tuple[0]][j] >= 0 && !failed; j++)
+        {
+            const uint8_t serial = successors[tuple[0]][j];
+            uint16_t next[CONSTRAINT_MAX_SIZE + 1] = {serial};
+            uint64_t key = serial;
+
+            for (uint8_t c = 0; c < size; c++)
+            {
+                next[c + 1] = constraints[c].next[tuple[c + 1] * 19 + serial];
+                key = (key * 0x100000001b3ull) ^ next[c + 1];
+            }
+
+            key ^= key >> 33;
+            key *= 0xff51afd7ed558ccdull;
+            key ^= key >> 33;
+
+            uint32_t slot = key & (hash_capacity - 1);
+
+            while (hash[slot] != 0 && memcmp(tuples + (size_t)(hash[slot] - 1) * width, next, width * sizeof(uint16_t)) != 0)
+                slot = (slot + 1) & (hash_capacity - 1);
+
+            if (hash[slot] == 0)
+            {
+                if (states == CONSTRAINT_MAX_PRODUCT)
+                {
+                    failed = true;
+                    break;
+                }
+
+                memcpy(tuples + (size_t)(states) * width, next, width * sizeof(uint16_t));
+                hash[slot] = ++states;
+            }
+
+            if (transitions == capacity)
+            {
+                capacity = capacity == 0 ? 1024 : capacity * 2;
+
+                uint8_t* grown_serials = (uint8_t*)(realloc(serials, capacity * sizeof(uint8_t)));
+
+                if (grown_serials != NULL)
+                    serials = grown_serials;
+
+                uint32_t* grown_targets = (uint32_t*)(realloc(targets, capacity * sizeof(uint32_t)));
+
+                if (grown_targets != NULL)
+                    targets = grown_targets;
+
+                failed = grown_serials == NULL || grown_targets == NULL;
+
+                if (failed)
+                    break;
+            }
+
+            serials[transitions] = serial;
+            targets[transitions++] = hash[slot] - 1;
+        }
+    }
+
+    // a state is alive if an accepting state can be reached from it, walking the transitions backwards
+    uint32_t* incoming = failed ? NULL : (uint32_t*)(calloc(states + 1, sizeof(uint32_t)));
+    uint32_t* sources = failed ? NULL : (uint32_t*)(malloc(transitions * sizeof(uint32_t) + 1));
+    uint32_t* renumber = failed ? NULL : (uint32_t*)(malloc(states * sizeof(uint32_t)));
+    uint32_t* queue = failed ? NULL : (uint32_t*)(malloc(states * sizeof(uint32_t)));
+    bool* accepting = failed ? NULL : (bool*)(calloc(states, sizeof(bool)));
+
+    failed |= incoming == NULL || sources == NULL || renumber == NULL || queue == NULL || accepting == NULL;
+
+    if (!failed)
+    {
+        uint32_t queue_size = 0;
+
+        first[states] = transitions;
+
+        for (uint32_t t = 0; t < transitions; t++)
+            incoming[targets[t] + 1]++;
+
+        for (uint32_t s = 0; s < states; s++)
+            incoming[s + 1] += incoming[s];
+
+        // sources of the transitions into every state, incoming[] is moved to the end of every range
+        for (uint32_t s = 0; s < states; s++)
+        {
+            for (uint32_t t = first[s]; t < first[s + 1]; t++)
+                sources[incoming[targets[t]]++] = s;
+        }
+
+        for (uint32_t s = states; s-- > 0;)
+            incoming[s + 1] = incoming[s];
+
+        incoming[0] = 0;
+
+        for (uint32_t s = 0; s < states; s++)
+        {
+            const uint16_t* tuple = tuples + (size_t)(s) * width;
+
+            accepting[s] = true;
+            renumber[s] = UINT32_MAX;
+
+            for (uint8_t c = 0; c < size; c++)
+                accepting[s] &= constraints[c].accepting[tuple[c + 1]];
+
+            if (accepting[s])
+            {
+                renumber[s] = 0;
+                queue[queue_size++] = s;
+            }
+        }
+
+        for (uint32_t i = 0; i < queue_size; i++)
+        {
+            for (uint32_t k = incoming[queue[i]]; k < incoming[queue[i] + 1]; k++)
+            {
+                if (renumber[sources[k]] == UINT32_MAX)
+                {
+                    renumber[sources[k]] = 0;
+                    queue[queue_size++] = sources[k];
+                }
+            }
+        }
+
+        // the alive states keep their order, the start stays state 0 even if no solution is allowed
+        automaton -> size = 0;
+
+        for (uint32_t s = 0; s < states; s++)
+        {
+            if (s == AUTOMATON_START || renumber[s] == 0)
+                renumber[s] = automaton -> size++;
+            else
+                renumber[s] = UINT32_MAX;
+        }
+
+        automaton -> first = (uint32_t*)(malloc((automaton -> size + 1) * sizeof(uint32_t)));
+        automaton -> serials = (uint8_t*)(malloc(transitions * sizeof(uint8_t) + 1));
+        automaton -> targets = (uint32_t*)(malloc(transitions * sizeof(uint32_t) + 1));
+        automaton -> accepting = (bool*)(malloc(automaton -> size * sizeof(bool)));
+        failed = automaton -> first == NULL || automaton -> serials == NULL || automaton -> targets == NULL || automaton -> accepting == NULL;
+    }
+
+    if (!failed)
+    {
+        uint32_t kept = 0;
+
+        for (uint32_t s = 0; s < states; s++)
+        {
+            if (renumber[s] == UINT32_MAX)
+                continue;
+
+            automaton -> first[renumber[s]] = kept;
+            automaton -> accepting[renumber[s]] = accepting[s];
+
+            for (uint32_t t = first[s]; t < first[s + 1]; t++)
+            {
+                if (renumber[targets[t]] == UINT32_MAX)
+                    continue;
+
+                automaton -> serials[kept] = serials[t];
+                automaton -> targets[kept++] = renumber[targets[t]];
+            }
+        }
+
+        automaton -> first[automaton -> size] = kept;
+        automaton -> nodes = states;
+        failed = !move_automaton_count(automaton, moves_map);
+    }
+
+    free(tuples);
+    free(hash);
+    free(first);
+    free(serials);
+    free(targets);
+    free(incoming);
+    free(sources);
+    free(renumber);
+    free(queue);
+    free(accepting);
+
+    if (failed)
+        move_automaton_free(automaton);
+
+    return !failed;
+}
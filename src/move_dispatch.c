@@ -0,0 +1,211 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "move.h"
+#include "move_simd.h"
+#include "move_dispatch.h"
+
+#define DISPATCH_CHAIN (1 << 16) // calls per timing of a single state kernel
+#define DISPATCH_BATCH 1024 // states per timing of a batch kernel
+#define DISPATCH_ROUNDS 5 // the best of these many timings is kept
+
+static bool dispatch_ready = false;
+static Move MOVE_KERNELS[19];
+static const char* MOVE_KERNEL_NAMES[19];
+static BatchTransform BATCH_KERNELS[19];
+static const char* BATCH_KERNEL_NAMES[19];
+static volatile uint32_t dispatch_sink; // keeps the timed chains alive
+
+// the scalar batch kernels go through the tuned single state kernels
+#define DEFINE_SCALAR_BATCH(serial)                                                         \
+    static void scalar_batch_##serial(const uint32_t* in, uint32_t* out, size_t n)          \
+    {                                                                                       \
+        uint32_t (*transform)(uint32_t) = MOVE_KERNELS[serial].transform;                   \
+                                                                                            \
+        for (size_t i = 0; i < n; i++)                                                      \
+            out[i] = transform(in[i]);                                                      \
+    }
+
+DEFINE_SCALAR_BATCH(0)  DEFINE_SCALAR_BATCH(1)  DEFINE_SCALAR_BATCH(2)  DEFINE_SCALAR_BATCH(3)
+DEFINE_SCALAR_BATCH(4)  DEFINE_SCALAR_BATCH(5)  DEFINE_SCALAR_BATCH(6)  DEFINE_SCALAR_BATCH(7)
+DEFINE_SCALAR_BATCH(8)  DEFINE_SCALAR_BATCH(9)  DEFINE_SCALAR_BATCH(10) DEFINE_SCALAR_BATCH(11)
+DEFINE_SCALAR_BATCH(12) DEFINE_SCALAR_BATCH(13) DEFINE_SCALAR_BATCH(14) DEFINE_SCALAR_BATCH(15)
+DEFINE_SCALAR_BATCH(16) DEFINE_SCALAR_BATCH(17) DEFINE_SCALAR_BATCH(18)
+
+static const BatchTransform SCALAR_BATCHES[19] = {
+    scalar_batch_0, scalar_batch_1, scalar_batch_2, scalar_batch_3, scalar_batch_4,
+    scalar_batch_5, scalar_batch_6, scalar_batch_7, scalar_batch_8, scalar_batch_9,
+    scalar_batch_10, scalar_batch_11, scalar_batch_12, scalar_batch_13, scalar_batch_14,
+    scalar_batch_15, scalar_batch_16, scalar_batch_17, scalar_batch_18
+};
+
+/**
+ *                       Returns a monotonic time stamp in nanoseconds.
+ */
+static uint64_t get_time_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ *                       Times a chain of calls of a single state kernel.
+ *
+ * Each call depends on the previous one, like the moves along a search path. The
+ * function is kept out of line so that the kernel is called through its pointer, the
+ * same way the solvers call it.
+ *
+ * @param transform             The kernel to time.
+ *
+ * @return                      The best time of DISPATCH_ROUNDS rounds in nanoseconds.
+ */
+static __attribute__((noipa)) uint64_t time_transform(uint32_t (*transform)(uint32_t))
+{
+    uint64_t best = UINT64_MAX;
+
+    for (uint8_t round = 0; round < DISPATCH_ROUNDS; round++)
+    {
+        uint32_t state = 87652123;
+        const uint64_t start = get_time_ns();
+
+        for (uint32_t i = 0; i < DISPATCH_CHAIN; i++)
+            state = transform(state);
+
+        const uint64_t elapsed = get_time_ns() - start;
+        best = elapsed < best ? elapsed : best;
+        dispatch_sink ^= state;
+    }
+
+    return best;
+}
+
+/**
+ *                       Times a batch kernel on DISPATCH_BATCH states.
+ *
+ * @param batch                 The kernel to time.
+ *
+ * @return                      The best time of DISPATCH_ROUNDS rounds in nanoseconds.
+ */
+static __attribute__((noipa)) uint64_t time_batch(BatchTransform batch)
+{
+    uint32_t states[DISPATCH_BATCH];
+    uint64_t best = UINT64_MAX;
+
+    for (uint32_t i = 0; i < DISPATCH_BATCH; i++)
+        states[i] = 87652123 ^ i;
+
+    for (uint8_t round = 0; round < DISPATCH_ROUNDS; round++)
+    {
+        const uint64_t start = get_time_ns();
+
+        for (uint8_t i = 0; i < 16; i++)
+            batch(states, states, DISPATCH_BATCH);
+
+        const uint64_t elapsed = get_time_ns() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+
+    dispatch_sink ^= states[0];
+    return best;
+}
+
+/**
+ *                       Detects the CPU features and picks the fastest kernel of every move.
+ *
+ * Every move has a scalar kernel, the face moves (R, L, F, B) also have a BMI2 kernel and
+ * every move has an AVX2 batch kernel. The kernels the CPU supports are timed on a short
+ * chain of calls and the fastest one is kept. Only the first call does the work, the
+ * result is shared by the whole program.
+ */
+void move_dispatch_init()
+{
+    const Move ALL_MOVES[19] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2};
+    uint32_t (*const SCALAR_FACES[4])(uint32_t) = {R_transform, L_transform, F_transform, B_transform};
+    uint32_t (*const BMI2_FACES[4])(uint32_t) = {R_transform_bmi2, L_transform_bmi2, F_transform_bmi2, B_transform_bmi2};
+
+    if (dispatch_ready)
+        return;
+
+    const bool bmi2 = move_bmi2_supported();
+    const bool avx2 = move_simd_supported();
+
+    for (uint8_t i = 0; i < 19; i++)
+    {
+        MOVE_KERNELS[i] = ALL_MOVES[i];
+        MOVE_KERNEL_NAMES[i] = "scalar";
+
+        // the face moves may be bound to BMI2 at build time, both versions compete here
+        if (i < 4)
+        {
+            MOVE_KERNELS[i].transform = SCALAR_FACES[i];
+
+            if (bmi2 && time_transform(BMI2_FACES[i]) < time_transform(SCALAR_FACES[i]))
+            {
+                MOVE_KERNELS[i].transform = BMI2_FACES[i];
+                MOVE_KERNEL_NAMES[i] = "bmi2";
+            }
+        }
+    }
+
+    // the scalar batches call MOVE_KERNELS, so they are timed once those are settled
+    for (uint8_t i = 0; i < 19; i++)
+    {
+        BATCH_KERNELS[i] = SCALAR_BATCHES[i];
+        BATCH_KERNEL_NAMES[i] = MOVE_KERNEL_NAMES[i];
+
+        if (avx2 && time_batch(BATCH_TRANSFORMS[i]) < time_batch(SCALAR_BATCHES[i]))
+        {
+            BATCH_KERNELS[i] = BATCH_TRANSFORMS[i];
+            BATCH_KERNEL_NAMES[i] = "avx2";
+        }
+    }
+
+    dispatch_ready = true;
+}
+
+/**
+ *                       Replaces the move functions with the fastest kernels.
+ *
+ * @param moves                 The moves to rebind, the kernel is chosen by serial, EMPTY moves are kept.
+ * @param size                  How many moves.
+ */
+void move_dispatch_bind(Move* moves, uint8_t size)
+{
+    move_dispatch_init();
+
+    for (uint8_t i = 0; i < size; i++)
+    {
+        if (moves[i].transform != NULL && moves[i].serial < 19)
+            moves[i].transform = MOVE_KERNELS[moves[i].serial].transform;
+    }
+}
+
+/**
+ *                       Returns the fastest batch kernel of a move.
+ *
+ * @param serial                The serial of the move (R = 0 ... Dw2 = 18).
+ *
+ * @return                      The AVX2 kernel, or a scalar loop if it is faster or AVX2 is missing.
+ */
+BatchTransform move_dispatch_batch(uint8_t serial)
+{
+    move_dispatch_init();
+    return BATCH_KERNELS[serial];
+}
+
+/**
+ *                       Returns the name of the kernel bound to a move.
+ *
+ * @param serial                The serial of the move (R = 0 ... Dw2 = 18).
+ * @param batch                 True for the batch kernel, false for the single state kernel.
+ *
+ * @return                      "scalar", "bmi2" or "avx2".
+ */
+const char* move_dispatch_name(uint8_t serial, bool batch)
+{
+    move_dispatch_init();
+    return batch ? BATCH_KERNEL_NAMES[serial] : MOVE_KERNEL_NAMES[serial];
+}
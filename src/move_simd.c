@@ -0,0 +1,272 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <immintrin.h>
+
+#include "move.h"
+#include "move_simd.h"
+
+#define AVX2 __attribute__((target("avx2")))
+
+/**
+ *                       Swaps two bit fields of every lane.
+ *
+ * @param v                     8 packed states.
+ * @param mask                  The mask of the higher field, the lower one is mask >> shift.
+ * @param shift                 The distance between the two fields.
+ *
+ * @return                      Both fields swapped, all other bits cleared.
+ */
+static inline AVX2 __m256i swap_fields(__m256i v, uint32_t mask, int shift)
+{
+    return _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(v, shift), _mm256_set1_epi32(mask >> shift)),
+                           _mm256_and_si256(_mm256_slli_epi32(v, shift), _mm256_set1_epi32(mask)));
+}
+
+/**
+ *                       Rotates a bit field of every lane.
+ *
+ * @param v                     8 packed states.
+ * @param mask                  The mask of the field.
+ * @param left                  How many bits to rotate left inside the field.
+ * @param right                 How many bits to rotate right inside the field (field width - left).
+ *
+ * @return                      The rotated field, all other bits cleared.
+ */
+static inline AVX2 __m256i rotate_field(__m256i v, uint32_t mask, int left, int right)
+{
+    const __m256i m = _mm256_set1_epi32(mask);
+    const __m256i field = _mm256_and_si256(v, m);
+
+    return _mm256_and_si256(_mm256_or_si256(_mm256_slli_epi32(field, left), _mm256_srli_epi32(field, right)), m);
+}
+
+/**
+ *                       Keeps the bits of every lane outside the given mask.
+ */
+static inline AVX2 __m256i keep_bits(__m256i v, uint32_t mask)
+{
+    return _mm256_andnot_si256(_mm256_set1_epi32(mask), v);
+}
+
+// corners: 0123 4567 => 0176 4532, edges: 0123 => 0132
+static inline AVX2 __m256i R_vector(__m256i v)
+{
+    return _mm256_or_si256(_mm256_or_si256(keep_bits(v, 0b111 << 23 | 0b111 << 20 | 0b111 << 11 | 0b111 << 8 | 0b1111),
+                                           swap_fields(v, 0b111 << 23, 15)),
+                           _mm256_or_si256(swap_fields(v, 0b111 << 20, 9), swap_fields(v, 0b11 << 2, 2)));
+}
+
+// corners: 0123 4567 => 5423 1067, edges: 0123 => 1023
+static inline AVX2 __m256i L_vector(__m256i v)
+{
+    return _mm256_or_si256(_mm256_or_si256(keep_bits(v, 0b111u << 29 | 0b111 << 26 | 0b111 << 17 | 0b111 << 14 | 0b1111 << 4),
+                                           swap_fields(v, 0b111u << 29, 15)),
+                           _mm256_or_si256(swap_fields(v, 0b111 << 26, 9), swap_fields(v, 0b11 << 6, 2)));
+}
+
+// corners: 0123 4567 => 7124 3560, edges: 0123 => 3120
+static inline AVX2 __m256i F_vector(__m256i v)
+{
+    return _mm256_or_si256(_mm256_or_si256(keep_bits(v, 0b111u << 29 | 0b111 << 20 | 0b111 << 17 | 0b111 << 8 | 0b11 << 6 | 0b11),
+                                           swap_fields(v, 0b111u << 29, 21)),
+                           _mm256_or_si256(swap_fields(v, 0b111 << 20, 3), swap_fields(v, 0b11 << 6, 6)));
+}
+
+// corners: 0123 4567 => 0653 4217, edges: 0123 => 0213
+static inline AVX2 __m256i B_vector(__m256i v)
+{
+    return _mm256_or_si256(_mm256_or_si256(keep_bits(v, 0b111 << 26 | 0b111 << 23 | 0b111 << 14 | 0b111 << 11 | 0b1111 << 2),
+                                           swap_fields(v, 0b111 << 26, 15)),
+                           _mm256_or_si256(swap_fields(v, 0b111 << 23, 9), swap_fields(v, 0b11 << 4, 2)));
+}
+
+#define UPPER_CORNERS 0xfff00000u
+#define LOWER_CORNERS 0x000fff00u
+#define EDGES 0x000000ffu
+
+/**
+ *                       Rotates the upper corners, the lower corners and the edges of every lane.
+ *
+ * A rotation of 0 bits leaves the layer untouched, this covers the U, E, D, Uw and Dw families.
+ */
+static inline AVX2 __m256i layers_vector(__m256i v, int upper_left, int lower_left, int edges_left)
+{
+    uint32_t keep = 0;
+    __m256i result = _mm256_setzero_si256();
+
+    if (upper_left != 0)
+    {
+        keep |= UPPER_CORNERS;
+        result = _mm256_or_si256(result, rotate_field(v, UPPER_CORNERS, upper_left, 12 - upper_left));
+    }
+
+    if (lower_left != 0)
+    {
+        keep |= LOWER_CORNERS;
+        result = _mm256_or_si256(result, rotate_field(v, LOWER_CORNERS, lower_left, 12 - lower_left));
+    }
+
+    if (edges_left != 0)
+    {
+        keep |= EDGES;
+        result = _mm256_or_si256(result, rotate_field(v, EDGES, edges_left, 8 - edges_left));
+    }
+
+    return _mm256_or_si256(result, keep_bits(v, keep));
+}
+
+static inline AVX2 __m256i U_vector(__m256i v) {return layers_vector(v, 9, 0, 0);}
+static inline AVX2 __m256i UPrime_vector(__m256i v) {return layers_vector(v, 3, 0, 0);}
+static inline AVX2 __m256i U2_vector(__m256i v) {return layers_vector(v, 6, 0, 0);}
+static inline AVX2 __m256i E_vector(__m256i v) {return layers_vector(v, 0, 0, 6);}
+static inline AVX2 __m256i EPrime_vector(__m256i v) {return layers_vector(v, 0, 0, 2);}
+static inline AVX2 __m256i E2_vector(__m256i v) {return layers_vector(v, 0, 0, 4);}
+static inline AVX2 __m256i D_vector(__m256i v) {return layers_vector(v, 0, 3, 0);}
+static inline AVX2 __m256i DPrime_vector(__m256i v) {return layers_vector(v, 0, 9, 0);}
+static inline AVX2 __m256i D2_vector(__m256i v) {return layers_vector(v, 0, 6, 0);}
+static inline AVX2 __m256i Uw_vector(__m256i v) {return layers_vector(v, 9, 0, 6);}
+static inline AVX2 __m256i UwPrime_vector(__m256i v) {return layers_vector(v, 3, 0, 2);}
+static inline AVX2 __m256i Uw2_vector(__m256i v) {return layers_vector(v, 6, 0, 4);}
+static inline AVX2 __m256i Dw_vector(__m256i v) {return layers_vector(v, 0, 3, 2);}
+static inline AVX2 __m256i DwPrime_vector(__m256i v) {return layers_vector(v, 0, 9, 6);}
+static inline AVX2 __m256i Dw2_vector(__m256i v) {return layers_vector(v, 0, 6, 4);}
+
+static bool avx2_checked = false;
+static bool avx2_supported = false;
+
+/**
+ *                       Checks if the CPU can run the AVX2 batch kernels.
+ *
+ * The *_x8 functions fall back to the scalar move functions when AVX2 is missing,
+ * this only tells the callers whether batching is worth it.
+ *
+ * @return                      True if AVX2 is available, false otherwise.
+ */
+bool move_simd_supported()
+{
+    if (!avx2_checked)
+    {
+        __builtin_cpu_init();
+        avx2_supported = __builtin_cpu_supports("avx2");
+        avx2_checked = true;
+    }
+
+    return avx2_supported;
+}
+
+// the vector loop lives in its own function so that it is never entered without AVX2
+#define DEFINE_BATCH_TRANSFORM(name)                                                        \
+    static AVX2 size_t name##_avx2(const uint32_t* in, uint32_t* out, size_t n)             \
+    {                                                                                       \
+        size_t i = 0;                                                                       \
+                                                                                            \
+        for (; i + 8 <= n; i += 8)                                                          \
+        {                                                                                   \
+            const __m256i v = _mm256_loadu_si256((const __m256i*)(in + i));                 \
+            _mm256_storeu_si256((__m256i*)(out + i), name##_vector(v));                     \
+        }                                                                                   \
+                                                                                            \
+        return i;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    void name##_transform_x8(const uint32_t* in, uint32_t* out, size_t n)                   \
+    {                                                                                       \
+        size_t i = move_simd_supported() ? name##_avx2(in, out, n) : 0;                     \
+                                                                                            \
+        for (; i < n; i++)                                                                  \
+            out[i] = name##_transform(in[i]);                                               \
+    }
+
+DEFINE_BATCH_TRANSFORM(R)
+DEFINE_BATCH_TRANSFORM(L)
+DEFINE_BATCH_TRANSFORM(F)
+DEFINE_BATCH_TRANSFORM(B)
+DEFINE_BATCH_TRANSFORM(U)
+DEFINE_BATCH_TRANSFORM(UPrime)
+DEFINE_BATCH_TRANSFORM(U2)
+DEFINE_BATCH_TRANSFORM(E)
+DEFINE_BATCH_TRANSFORM(EPrime)
+DEFINE_BATCH_TRANSFORM(E2)
+DEFINE_BATCH_TRANSFORM(D)
+DEFINE_BATCH_TRANSFORM(DPrime)
+DEFINE_BATCH_TRANSFORM(D2)
+DEFINE_BATCH_TRANSFORM(Uw)
+DEFINE_BATCH_TRANSFORM(UwPrime)
+DEFINE_BATCH_TRANSFORM(Uw2)
+DEFINE_BATCH_TRANSFORM(Dw)
+DEFINE_BATCH_TRANSFORM(DwPrime)
+DEFINE_BATCH_TRANSFORM(Dw2)
+
+const BatchTransform BATCH_TRANSFORMS[19] = {
+    R_transform_x8, L_transform_x8, F_transform_x8, B_transform_x8,
+    U_transform_x8, UPrime_transform_x8, U2_transform_x8,
+    E_transform_x8, EPrime_transform_x8, E2_transform_x8,
+    D_transform_x8, DPrime_transform_x8, D2_transform_x8,
+    Uw_transform_x8, UwPrime_transform_x8, Uw2_transform_x8,
+    Dw_transform_x8, DwPrime_transform_x8, Dw2_transform_x8
+};
+
+/**
+ *                       Checks 8 states at a time against the 8 original states.
+ *
+ * @return                      How many states are handled (a multiple of 8).
+ */
+static AVX2 size_t is_original_state_avx2(const uint32_t* states, size_t n, const int* original_states,
+                                           bool* hits, size_t* count)
+{
+    __m256i originals[8];
+    size_t i = 0;
+
+    for (uint8_t j = 0; j < 8; j++)
+        originals[j] = _mm256_set1_epi32(original_states[j]);
+
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m256i v = _mm256_loadu_si256((const __m256i*)(states + i));
+        __m256i equal = _mm256_cmpeq_epi32(v, originals[0]);
+
+        for (uint8_t j = 1; j < 8; j++)
+            equal = _mm256_or_si256(equal, _mm256_cmpeq_epi32(v, originals[j]));
+
+        const uint32_t mask = _mm256_movemask_ps(_mm256_castsi256_ps(equal));
+
+        for (uint8_t j = 0; j < 8; j++)
+            hits[i + j] = mask >> j & 1;
+
+        *count += __builtin_popcount(mask);
+    }
+
+    return i;
+}
+
+/**
+ *                       Checks a batch of states against the original states.
+ *
+ * This is the batch version of is_original_state, each state is compared against all
+ * 8 original states at once.
+ *
+ * @param states                n packed states to check.
+ * @param n                     How many states to check.
+ * @param original_states       An array of 8 original states to check against.
+ * @param hits                  Where to store the result, hits[i] is true if states[i] is an original state.
+ *
+ * @return                      How many states are original states.
+ */
+size_t is_original_state_x8(const uint32_t* states, size_t n, const int* original_states, bool* hits)
+{
+    size_t count = 0;
+    size_t i = move_simd_supported() ? is_original_state_avx2(states, n, original_states, hits, &count) : 0;
+
+    for (; i < n; i++)
+    {
+        hits[i] = false;
+
+        for (uint8_t j = 0; j < 8; j++)
+            hits[i] |= states[i] == (uint32_t)(original_states[j]);
+
+        count += hits[i];
+    }
+
+    return count;
+}
@@ -0,0 +1,203 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "move_table.h"
+#include "cube_rank.h"
+#include "cube_symmetry.h"
+
+/**
+ *                       Ranks a packed state the way a table indexes it.
+ *
+ * @param table                 The table.
+ * @param state                 The packed state.
+ *
+ * @return                      The corner rank or the state rank.
+ */
+static uint32_t move_table_rank(const MoveTable* table, uint32_t state)
+{
+    return table -> corners_only ? corners_rank(state) : cube_state_rank(state);
+}
+
+/**
+ *                       Builds the transition table of all reachable states.
+ *
+ * This function indexes every state reachable from the original states with the 19
+ * moves of the 223 cube by its rank (corners only when the original states ignore the
+ * edges) and stores, for every index and every move, the index of the resulting state.
+ * Solvers can then walk the table instead of calling the move functions.
+ *
+ * A symmetric table only indexes the representatives picked by cube_canonical, about 16
+ * times fewer states. Its indices carry the symmetry from the walked state to the
+ * representative in their 4 lowest bits, see move_table_next.
+ *
+ * @param table                 The table to build.
+ * @param original_states       The 8 original states, only used to tell if the edges are ignored.
+ * @param symmetric             Index the symmetry classes instead of the states.
+ *
+ * @return                      True if the table is built, false if out of memory.
+ */
+bool move_table_create(MoveTable* table, const int* original_states, bool symmetric)
+{
+    const Move ALL_MOVES[MOVE_TABLE_MOVES] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2};
+
+    // every corner and edge permutation is reachable, so the dense index is the rank itself
+    table -> corners_only = (original_states[0] & 0xff) == 0;
+    table -> symmetric = symmetric;
+    table -> size = table -> corners_only ? CUBE_CORNERS_SIZE : CUBE_STATES_SIZE;
+    table -> states = NULL;
+    table -> next_state = NULL;
+
+    // rank => dense index of the representative, only needed while building
+    uint32_t* classes = NULL;
+
+    if (symmetric)
+    {
+        cube_symmetry_init();
+        classes = (uint32_t*)(malloc(table -> size * sizeof(uint32_t)));
+
+        if (classes == NULL)
+            return false;
+
+        const uint32_t ranks = table -> size;
+        table -> size = 0;
+
+        for (uint32_t i = 0; i < ranks; i++)
+        {
+            const uint32_t state = table -> corners_only ? corners_unrank(i) : cube_state_unrank(i);
+
+            if (cube_canonical(state, NULL) == state)
+                classes[i] = table -> size++;
+        }
+    }
+
+    table -> states = (uint32_t*)(malloc(table -> size * sizeof(uint32_t)));
+    table -> next_state = (uint32_t*)(malloc((size_t)(table -> size) * MOVE_TABLE_MOVES * sizeof(uint32_t)));
+
+    if (table -> states == NULL || table -> next_state == NULL)
+    {
+        free(classes);
+        move_table_free(table);
+        return false;
+    }
+
+    for (uint32_t i = 0, rank = 0; i < table -> size; rank++)
+    {
+        const uint32_t state = table -> corners_only ? corners_unrank(rank) : cube_state_unrank(rank);
+
+        // the representatives were numbered in rank order
+        if (!symmetric || cube_canonical(state, NULL) == state)
+            table -> states[i++] = state;
+    }
+
+    for (uint32_t i = 0; i < table -> size; i++)
+    {
+        uint32_t* next_state = table -> next_state + (size_t)(i) * MOVE_TABLE_MOVES;
+
+        for (uint8_t j = 0; j < MOVE_TABLE_MOVES; j++)
+        {
+            const uint32_t new_state = ALL_MOVES[j].transform(table -> states[i]);
+
+            if (symmetric)
+            {
+                uint8_t symmetry;
+                const uint32_t representative = cube_canonical(new_state, &symmetry);
+
+                next_state[j] = classes[move_table_rank(table, representative)] << 4 | symmetry;
+            }
+            else
+                next_state[j] = move_table_rank(table, new_state);
+        }
+    }
+
+    free(classes);
+    return true;
+}
+
+/**
+ *                       Frees all the memory allocated by a transition table.
+ *
+ * @param table                 The table to free.
+ */
+void move_table_free(MoveTable* table)
+{
+    free(table -> states);
+    free(table -> next_state);
+
+    table -> size = 0;
+    table -> states = NULL;
+    table -> next_state = NULL;
+}
+
+/**
+ *                       Looks up the dense index of a packed state.
+ *
+ * @param table                 The table to search in.
+ * @param state                 The packed state to look up.
+ *
+ * @return                      The dense index of the state, or -1 if the state is not reachable.
+ */
+int64_t move_table_index(const MoveTable* table, uint32_t state)
+{
+    if (!cube_state_valid(state) || table -> corners_only != ((state & 0xff) == 0))
+        return -1;
+
+    if (!table -> symmetric)
+        return move_table_rank(table, state);
+
+    // the representatives are sorted by rank
+    uint8_t symmetry;
+    const uint32_t rank = move_table_rank(table, cube_canonical(state, &symmetry));
+    uint32_t low = 0, high = table -> size;
+
+    while (high - low > 1)
+    {
+        const uint32_t middle = (low + high) / 2;
+
+        if (move_table_rank(table, table -> states[middle]) <= rank)
+            low = middle;
+        else
+            high = middle;
+    }
+
+    return (int64_t)(low) << 4 | symmetry;
+}
+
+/**
+ *                       Applies a move to a dense index.
+ *
+ * In a symmetric table, the index holds a representative and the symmetry sending the
+ * walked state to it. The move is first mapped through that symmetry, then the symmetry
+ * to the next representative is composed with it.
+ *
+ * @param table                 The table to walk.
+ * @param index                 The dense index, from move_table_index or move_table_next.
+ * @param serial                The serial of the move (R = 0 ... Dw2 = 18).
+ *
+ * @return                      The dense index of the new state.
+ */
+uint32_t move_table_next(const MoveTable* table, uint32_t index, uint8_t serial)
+{
+    if (!table -> symmetric)
+        return table -> next_state[(size_t)(index) * MOVE_TABLE_MOVES + serial];
+
+    const uint8_t symmetry = index & 0xf;
+    const uint32_t next = table -> next_state[(size_t)(index >> 4) * MOVE_TABLE_MOVES + CUBE_SYMMETRY[symmetry].moves[serial]];
+
+    return (next & ~0xfu) | CUBE_SYMMETRY_PRODUCT[next & 0xf][symmetry];
+}
+
+/**
+ *                       Looks up the packed state of a dense index.
+ *
+ * The packed state of a symmetric table is the representative of the class, it is solved
+ * exactly when the walked state is.
+ *
+ * @param table                 The table to search in.
+ * @param index                 The dense index.
+ *
+ * @return                      The packed state.
+ */
+uint32_t move_table_state(const MoveTable* table, uint32_t index)
+{
+    return table -> states[table -> symmetric ? index >> 4 : index];
+}
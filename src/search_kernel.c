@@ -0,0 +1,42 @@
+#include <stdint.h>
+#include <stddef.h>
+
+#include "search_kernel.h"
+
+/**
+ *                       Finds the generated kernel of a moves map.
+ *
+ * A kernel matches if every row of moves_map allows the same moves after its move, in the
+ * same order, as the settings file it was generated from, so it finds the same solutions
+ * in the same order as the generic search.
+ *
+ * @param moves_map             A 2D array of moves (19 x 19), as given to the solvers.
+ *
+ * @return                      The kernel, or NULL if no settings file had this moves map.
+ */
+const SearchKernel* search_kernel_find(const Move* moves_map)
+{
+    for (uint8_t k = 0; k < SEARCH_KERNELS_SIZE; k++)
+    {
+        const SearchKernel* kernel = SEARCH_KERNELS + k;
+        bool match = true;
+
+        for (uint8_t i = 0; i < 19 && match; i++)
+        {
+            uint8_t size = 0;
+
+            while (size < 18 && moves_map[i * 19 + size + 1].transform != NULL)
+                size++;
+
+            match = size == kernel -> successors_size[i];
+
+            for (uint8_t j = 0; j < size && match; j++)
+                match = moves_map[i * 19 + j + 1].serial == kernel -> successors[i][j];
+        }
+
+        if (match)
+            return kernel;
+    }
+
+    return NULL;
+}
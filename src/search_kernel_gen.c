@@ -0,0 +1,511 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <cJSON.h>
+
+#include "move.h"
+#include "move_canonical.h"
+
+#define GEN_SHIFTS 63 // the shifts of a field, -31 to 31 bits
+#define GEN_CHECKS 1000000 // how many random states every generated move is checked against
+
+static const char* MOVE_NAMES[19] = {"R", "L", "F", "B", "U", "UPrime", "U2", "E", "EPrime", "E2",
+                                     "D", "DPrime", "D2", "Uw", "UwPrime", "Uw2", "Dw", "DwPrime", "Dw2"};
+
+typedef struct gen_kernel
+{
+    char name[64]; // the file name without directory and extension, as a C identifier
+    uint8_t successors[19][19]; // successors[m]: the serials allowed after move m, in moves_map order
+    uint8_t successors_size[19];
+} GenKernel;
+
+/**
+ *                       Builds the shift network of a move.
+ *
+ * A move only moves the 3-bit corner fields and the 2-bit edge fields of a packed state
+ * around, so it is the OR of the fields of every shift, masked and shifted. The fields are
+ * found by applying the move to a state with a different piece on every position.
+ *
+ * @param move                  The move.
+ * @param masks                 masks[shift + 31]: the source bits moved by shift bits to the left (right if negative).
+ */
+static void gen_move_network(const Move* move, uint32_t* masks)
+{
+    uint32_t probe = 0;
+
+    memset(masks, 0, GEN_SHIFTS * sizeof(uint32_t));
+
+    for (uint8_t i = 0; i < 8; i++)
+        probe |= (uint32_t)(i) << (29 - 3 * i);
+
+    for (uint8_t i = 0; i < 4; i++)
+        probe |= (uint32_t)(i) << (6 - 2 * i);
+
+    const uint32_t moved = move -> transform(probe);
+
+    for (int8_t i = 0; i < 8; i++)
+    {
+        const int8_t source = moved >> (29 - 3 * i) & 0b111;
+
+        masks[3 * (source - i) + 31] |= 0b111u << (29 - 3 * source);
+    }
+
+    for (int8_t i = 0; i < 4; i++)
+    {
+        const int8_t source = moved >> (6 - 2 * i) & 0b11;
+
+        masks[2 * (source - i) + 31] |= 0b11u << (6 - 2 * source);
+    }
+}
+
+/**
+ *                       Applies a shift network to a state.
+ *
+ * @param masks                 The network, as built by gen_move_network.
+ * @param state                 The packed state.
+ *
+ * @return                      The moved state.
+ */
+static uint32_t gen_move_apply(const uint32_t* masks, uint32_t state)
+{
+    uint32_t result = 0;
+
+    for (int8_t shift = -31; shift <= 31; shift++)
+        result |= shift >= 0 ? (state & masks[shift + 31]) << shift : (state & masks[shift + 31]) >> -shift;
+
+    return result;
+}
+
+/**
+ *                       Writes the inlined version of a move.
+ *
+ * The network is checked against the move function on random states first, so a move that
+ * is not a permutation of the fields is never generated wrong.
+ *
+ * @param out                   The generated file.
+ * @param move                  The move.
+ *
+ * @return                      True if written, false if the move is not a permutation of the fields.
+ */
+static bool gen_move(FILE* out, const Move* move)
+{
+    uint32_t masks[GEN_SHIFTS];
+    uint32_t state = 0x9e3779b9;
+    bool first = true;
+
+    gen_move_network(move, masks);
+
+    for (uint32_t i = 0; i < GEN_CHECKS; i++)
+    {
+        // xorshift32
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        if (gen_move_apply(masks, state) != move -> transform(state))
+            return false;
+    }
+
+    fprintf(out, "static inline uint32_t kernel_move_%s(uint32_t state)\n{\n    return ", MOVE_NAMES[move -> serial]);
+
+    for (int8_t shift = -31; shift <= 31; shift++)
+    {
+        if (masks[shift + 31] == 0)
+            continue;
+
+        fprintf(out, "%s(state & 0x%08xu)", first ? "" : " |\n           ", masks[shift + 31]);
+
+        if (shift != 0)
+            fprintf(out, " %s %d", shift > 0 ? "<<" : ">>", shift > 0 ? shift : -shift);
+
+        first = false;
+    }
+
+    fprintf(out, "%s;\n}\n\n", first ? "0" : "");
+    return true;
+}
+
+/**
+ *                       Writes the edge phase update of a move.
+ *
+ * The table lookup is left out for the moves that never change the edge phase.
+ *
+ * @param out                   The generated file.
+ * @param serial                The serial of the move.
+ * @param phase                 The expression of the edge phase before the move.
+ */
+static void gen_phase(FILE* out, uint8_t serial, const char* phase)
+{
+    for (uint16_t p = 0; p < 256; p++)
+    {
+        if (EDGE_PHASE_TABLE[serial][p] != p)
+        {
+            fprintf(out, "EDGE_PHASE_TABLE[%d][%s]", serial, phase);
+            return;
+        }
+    }
+
+    fprintf(out, "%s", phase);
+}
+
+/**
+ *                       Reads the moves map of a settings file.
+ *
+ * The rows are read the way cube_solver reads them: row i holds the moves allowed after
+ * the move of serial i, from its second item up to the first one that is not a move.
+ *
+ * @param kernel                The kernel to fill.
+ * @param path                  The settings file.
+ *
+ * @return                      True if read, false if the file is missing or has no moves map.
+ */
+static bool gen_read(GenKernel* kernel, const char* path)
+{
+    FILE* file = fopen(path, "rb");
+
+    if (file == NULL)
+        return false;
+
+    fseek(file, 0, SEEK_END);
+
+    const long size = ftell(file);
+    char* text = (char*)(malloc(size + 1));
+
+    fseek(file, 0, SEEK_SET);
+
+    if (text == NULL || fread(text, 1, size, file) != (size_t)(size))
+    {
+        free(text);
+        fclose(file);
+        return false;
+    }
+
+    text[size] = '\0';
+    fclose(file);
+
+    const Move ALL_MOVES[19] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2};
+    cJSON* json = cJSON_Parse(text);
+    const cJSON* map = cJSON_GetObjectItemCaseSensitive(json, "moves_map");
+
+    free(text);
+
+    if (!cJSON_IsArray(map))
+    {
+        cJSON_Delete(json);
+        return false;
+    }
+
+    memset(kernel, 0, sizeof(GenKernel));
+
+    for (uint8_t i = 0; i < cJSON_GetArraySize(map) && i < 19; i++)
+    {
+        const cJSON* row = cJSON_GetArrayItem(map, i);
+
+        for (uint8_t j = 1; j < cJSON_GetArraySize(row) && j < 19; j++)
+        {
+            const cJSON* item = cJSON_GetArrayItem(row, j);
+            uint8_t k = 0;
+
+            while (k < 19 && !(cJSON_IsString(item) && strcmp(item -> valuestring, ALL_MOVES[k].symbol) == 0))
+                k++;
+
+            if (k == 19)
+                break;
+
+            kernel -> successors[i][kernel -> successors_size[i]++] = k;
+        }
+    }
+
+    cJSON_Delete(json);
+
+    const char* base = strrchr(path, '/') != NULL ? strrchr(path, '/') + 1 : path;
+    uint8_t length = 0;
+
+    // room is left for the "_canonical" suffix
+    for (; base[length] != '\0' && base[length] != '.' && length < sizeof(kernel -> name) - 16; length++)
+        kernel -> name[length] = isalnum((unsigned char)(base[length])) ? base[length] : '_';
+
+    if (length == 0 || isdigit((unsigned char)(kernel -> name[0])))
+    {
+        memmove(kernel -> name + 1, kernel -> name, length);
+        kernel -> name[0] = '_';
+    }
+
+    return true;
+}
+
+/**
+ *                       Builds the kernel of the canonical moves map of a kernel.
+ *
+ * cube_solver tightens moves_map with moves_map_canonical unless told not to, so the
+ * tightened map gets a kernel of its own when it differs from the settings file.
+ *
+ * @param canonical             The kernel to fill.
+ * @param kernel                The kernel of the settings file.
+ *
+ * @return                      True if moves_map_canonical removed any successor.
+ */
+static bool gen_canonical(GenKernel* canonical, const GenKernel* kernel)
+{
+    const Move ALL_MOVES[19] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2};
+    Move moves_map[19 * 19];
+
+    for (uint8_t i = 0; i < 19; i++)
+    {
+        moves_map[i * 19] = ALL_MOVES[i];
+
+        for (uint8_t j = 1; j < 19; j++)
+            moves_map[i * 19 + j] = j <= kernel -> successors_size[i] ? ALL_MOVES[kernel -> successors[i][j - 1]] : EMPTY;
+    }
+
+    if (moves_map_canonical(moves_map, NULL) == 0)
+        return false;
+
+    memset(canonical, 0, sizeof(GenKernel));
+    strcpy(canonical -> name, kernel -> name);
+    strcat(canonical -> name, "_canonical");
+
+    for (uint8_t i = 0; i < 19; i++)
+    {
+        for (uint8_t j = 1; j < 19 && moves_map[i * 19 + j].transform != NULL; j++)
+            canonical -> successors[i][canonical -> successors_size[i]++] = moves_map[i * 19 + j].serial;
+    }
+
+    return true;
+}
+
+/**
+ *                       Writes the DFS step of a move.
+ *
+ * A step plays the move, reports or stops at an original state, and searches on after it
+ * unless the path is max_depth long.
+ *
+ * @param out                   The generated file.
+ * @param kernel                The kernel.
+ * @param serial                The serial of the move.
+ */
+static void gen_step(FILE* out, const GenKernel* kernel, uint8_t serial)
+{
+    const char* name = kernel -> name;
+    const char* move = MOVE_NAMES[serial];
+
+    fprintf(out, "static inline void %s_step_%s(KernelSearch* search, uint32_t state, uint8_t phase, uint8_t depth)\n{\n", name, move);
+    fprintf(out, "    const uint32_t new_state = kernel_move_%s(state);\n", move);
+    fprintf(out, "    const uint8_t new_phase = ");
+    gen_phase(out, serial, "phase");
+    fprintf(out, ";\n\n");
+    fprintf(out, "    search -> path[depth] = %d;\n\n", serial);
+    fprintf(out, "    if (depth + 1 >= search -> min_depth && kernel_original(search, new_state))\n    {\n");
+    fprintf(out, "        if (search -> edges_all0 || edge_phase_solved(new_phase))\n");
+    fprintf(out, "            search -> report(search, depth + 1);\n\n");
+    fprintf(out, "        return;\n    }\n\n");
+    fprintf(out, "    if (depth + 1 < search -> max_depth)\n");
+    fprintf(out, "        %s_after_%s(search, new_state, new_phase, depth + 1);\n}\n\n", name, move);
+}
+
+/**
+ *                       Writes the search kernel of a moves map.
+ *
+ * Every move gets a function that tries the moves allowed after it one after the other,
+ * so the successor lists are code instead of rows walked at run time, and the moves are
+ * inlined into them.
+ *
+ * @param out                   The generated file.
+ * @param kernel                The kernel.
+ */
+static void gen_kernel(FILE* out, const GenKernel* kernel)
+{
+    const char* name = kernel -> name;
+    bool used[19] = {false}; // the moves a search can play
+    bool followed[19] = {false}; // the moves that follow another one
+
+    for (uint8_t i = 0; i < 19; i++)
+    {
+        used[i] |= kernel -> successors_size[i] > 0;
+
+        for (uint8_t j = 0; j < kernel -> successors_size[i]; j++)
+            used[kernel -> successors[i][j]] = followed[kernel -> successors[i][j]] = true;
+    }
+
+    fprintf(out, "// %s\n\n", name);
+
+    for (uint8_t i = 0; i < 19; i++)
+    {
+        if (used[i])
+            fprintf(out, "static void %s_after_%s(KernelSearch* search, uint32_t state, uint8_t phase, uint8_t depth);\n", name, MOVE_NAMES[i]);
+    }
+
+    fprintf(out, "\n");
+
+    for (uint8_t i = 0; i < 19; i++)
+    {
+        if (followed[i])
+            gen_step(out, kernel, i);
+    }
+
+    for (uint8_t i = 0; i < 19; i++)
+    {
+        if (!used[i])
+            continue;
+
+        fprintf(out, "static void %s_after_%s(KernelSearch* search, uint32_t state, uint8_t phase, uint8_t depth)\n{\n",
+                name, MOVE_NAMES[i]);
+
+        if (kernel -> successors_size[i] == 0)
+            fprintf(out, "    (void)(search);\n    (void)(state);\n    (void)(phase);\n    (void)(depth);\n");
+
+        for (uint8_t j = 0; j < kernel -> successors_size[i]; j++)
+            fprintf(out, "    %s_step_%s(search, state, phase, depth);\n", name, MOVE_NAMES[kernel -> successors[i][j]]);
+
+        fprintf(out, "}\n\n");
+    }
+
+    fprintf(out, "static void %s_dfs(KernelSearch* search, uint32_t state, uint8_t phase, uint8_t depth)\n{\n", name);
+    fprintf(out, "    switch (search -> path[depth - 1])\n    {\n");
+
+    for (uint8_t i = 0; i < 19; i++)
+    {
+        if (used[i])
+            fprintf(out, "        case %d: %s_after_%s(search, state, phase, depth); break;\n", i, name, MOVE_NAMES[i]);
+    }
+
+    fprintf(out, "        default: break;\n    }\n}\n\n");
+
+    fprintf(out, "static uint8_t %s_expand(uint32_t state, uint8_t phase, uint8_t last_move, uint32_t* states, uint8_t* phases, uint8_t* serials)\n{\n", name);
+    fprintf(out, "    switch (last_move)\n    {\n");
+
+    for (uint8_t i = 0; i < 19; i++)
+    {
+        if (kernel -> successors_size[i] == 0)
+            continue;
+
+        fprintf(out, "        case %d:\n", i);
+
+        for (uint8_t j = 0; j < kernel -> successors_size[i]; j++)
+        {
+            const uint8_t serial = kernel -> successors[i][j];
+
+            fprintf(out, "            states[%d] = kernel_move_%s(state);\n", j, MOVE_NAMES[serial]);
+            fprintf(out, "            phases[%d] = ", j);
+            gen_phase(out, serial, "phase");
+            fprintf(out, ";\n            serials[%d] = %d;\n", j, serial);
+        }
+
+        fprintf(out, "            return %d;\n", kernel -> successors_size[i]);
+    }
+
+    fprintf(out, "        default:\n            return 0;\n    }\n}\n\n");
+}
+
+/**
+ *                       Generates the search kernels of settings files.
+ *
+ * usage: search_kernel_gen <output.c> [settings.json ...]
+ *
+ * The output defines SEARCH_KERNELS, see search_kernel.h.
+ */
+int main(int argc, char** argv)
+{
+    const Move ALL_MOVES[19] = {R, L, F, B, U, UPrime, U2, E, EPrime, E2, D, DPrime, D2, Uw, UwPrime, Uw2, Dw, DwPrime, Dw2};
+
+    if (argc < 2)
+    {
+        printf("usage: %s <output.c> [settings.json ...]\n", argv[0]);
+        return 1;
+    }
+
+    // every file may add a canonical kernel
+    const uint8_t files = argc - 2 < 127 ? argc - 2 : 127;
+    GenKernel* kernels = (GenKernel*)(calloc(2 * files + 1, sizeof(GenKernel)));
+    uint8_t size = 0;
+    FILE* out = fopen(argv[1], "w");
+
+    if (kernels == NULL || out == NULL)
+    {
+        printf("Failed to open %s\n", argv[1]);
+        return 1;
+    }
+
+    edge_phase_table_init();
+
+    for (uint8_t i = 0; i < files; i++)
+    {
+        if (!gen_read(kernels + size, argv[i + 2]))
+        {
+            printf("Invalid settings file: %s\n", argv[i + 2]);
+            return 1;
+        }
+
+        for (uint8_t j = 0; j < size; j++)
+        {
+            if (strcmp(kernels[size].name, kernels[j].name) == 0)
+            {
+                printf("Two settings files are named %s\n", kernels[size].name);
+                return 1;
+            }
+        }
+
+        size++;
+        size += gen_canonical(kernels + size, kernels + size - 1);
+    }
+
+    fprintf(out, "// generated by search_kernel_gen, do not edit\n\n");
+    fprintf(out, "#include <stdint.h>\n#include <stdbool.h>\n#include <stddef.h>\n\n#include \"search_kernel.h\"\n\n");
+
+    for (uint8_t i = 0; i < 19; i++)
+    {
+        if (!gen_move(out, ALL_MOVES + i))
+        {
+            printf("Move %s does not only permute the fields of the state\n", ALL_MOVES[i].symbol);
+            return 1;
+        }
+    }
+
+    fprintf(out, "static inline bool kernel_original(const KernelSearch* search, uint32_t state)\n{\n");
+    fprintf(out, "    const int* original = search -> original_states;\n");
+    fprintf(out, "    const int value = (int)(state);\n\n");
+    fprintf(out, "    return value == original[0] || value == original[1] || value == original[2] || value == original[3] ||\n");
+    fprintf(out, "           value == original[4] || value == original[5] || value == original[6] || value == original[7];\n}\n\n");
+
+    for (uint8_t i = 0; i < size; i++)
+        gen_kernel(out, kernels + i);
+
+    // an empty array is not valid C, the size tells the entry is not a kernel
+    fprintf(out, "const SearchKernel SEARCH_KERNELS[%d] = {\n", size > 0 ? size : 1);
+
+    for (uint8_t i = 0; i < size; i++)
+    {
+        const GenKernel* kernel = kernels + i;
+
+        fprintf(out, "    {\"%s\", {", kernel -> name);
+
+        for (uint8_t m = 0; m < 19; m++)
+        {
+            fprintf(out, "%s{", m > 0 ? ", " : "");
+
+            for (uint8_t j = 0; j < kernel -> successors_size[m]; j++)
+                fprintf(out, "%s%d", j > 0 ? ", " : "", kernel -> successors[m][j]);
+
+            fprintf(out, "%s}", kernel -> successors_size[m] == 0 ? "0" : "");
+        }
+
+        fprintf(out, "}, {");
+
+        for (uint8_t m = 0; m < 19; m++)
+            fprintf(out, "%s%d", m > 0 ? ", " : "", kernel -> successors_size[m]);
+
+        fprintf(out, "}, %s_dfs, %s_expand},\n", kernel -> name, kernel -> name);
+    }
+
+    if (size == 0)
+        fprintf(out, "    {NULL}\n");
+
+    fprintf(out, "};\n\nconst uint8_t SEARCH_KERNELS_SIZE = %d;\n", size);
+    fclose(out);
+    free(kernels);
+    return 0;
+}
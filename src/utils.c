@@ -60,30 +60,41 @@ void my_itoa(int num, char* str, int base)
 }
 
 /**
- * Reads the contents of a file into a given string. The string is not
- * necessarily null-terminated, but the last character will be set to '\0' to
- * make it null-terminated.
+ * Reads the contents of a file into a new string. The string is allocated to
+ * the size of the file and null-terminated, so files of any size fit.
  *
- * @param result The string to store the result in.
  * @param file_path The path to the file to read from.
+ *
+ * @return The contents of the file, to be freed by the caller, or NULL if the
+ *         file cannot be read.
  */
-void read_from_file(char* result, const char* file_path)
+char* read_from_file(const char* file_path)
 {
     FILE* file = fopen(file_path, "r");
 
     if (!file)
     {
         printf("Error opening file: %s\n", file_path);
-        return;
+        return NULL;
     }
 
     fseek(file, 0, SEEK_END);
     long file_size = ftell(file);
     fseek(file, 0, SEEK_SET);
 
+    char* result = file_size >= 0 ? (char*)(malloc(file_size + 1)) : NULL;
+
+    if (result == NULL)
+    {
+        printf("Error reading file: %s\n", file_path);
+        fclose(file);
+        return NULL;
+    }
+
     size_t bytes_read = fread(result, 1, file_size, file);
     result[bytes_read] = '\0';
     fclose(file);
+    return result;
 }
 
 /**
@@ -95,20 +106,19 @@ void read_from_file(char* result, const char* file_path)
  * returns false.
  *
  * @param state             The current state to check.
- * @param original_state    An array of original states to check against (ranked).
+ * @param original_state    An array of 8 original states to check against.
  *
  * @return                      True if the current state is an original state, false otherwise.
  */
 
 bool is_original_state(int state, const int* original_state)
 {
-    if (state > 0)
-        return state > original_state[6] ? (state == original_state[6]) || (state == original_state[7]) :
-                                           (state == original_state[4]) || (state == original_state[5]);
-    else
-        return state > original_state[3] ? (state == original_state[3]) || (state == original_state[4]) :
-                                           (state == original_state[0]) || (state == original_state[1]);
-    
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        if (state == original_state[i])
+            return true;
+    }
+
     return false;
 }
 